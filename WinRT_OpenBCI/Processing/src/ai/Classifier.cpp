@@ -18,6 +18,68 @@
 #include "Learning.h"
 
 using namespace Platform;
+using namespace Platform::Collections;
+
+namespace
+{
+   struct EvaluationEqual
+   {
+      bool operator()(const Processing::ModelEvaluation& a, const Processing::ModelEvaluation& b) const
+      {
+         return a.Cascade == b.Cascade && a.LayerSize == b.LayerSize && a.LayerCount == b.LayerCount && a.Optimizer == b.Optimizer &&
+            a.Accuracy == b.Accuracy && a.AccuracyDeviation == b.AccuracyDeviation &&
+            a.TrainingSeconds == b.TrainingSeconds && a.LatencyMicroseconds == b.LatencyMicroseconds;
+      }
+   };
+
+   template <typename TData>
+   Processing::ModelGrid<TData> MakeGrid(const Array<int32>^ layerSizes, const Array<int32>^ layerCounts,
+                                         bool includeCascade, const Array<Processing::TrainingOptimizer>^ optimizers, int32 folds,
+                                         int32 maxEpochs)
+   {
+      Processing::ModelGrid<TData> grid;
+      for (int32 size : layerSizes) {
+         if (size < 1)
+            throw ref new InvalidArgumentException();
+         grid.layerSizes.push_back(size);
+      }
+      for (int32 count : layerCounts) {
+         if (count < 1)
+            throw ref new InvalidArgumentException();
+         grid.layerCounts.push_back(count);
+      }
+      if (includeCascade)
+         grid.types.push_back(Processing::ModelType::CascadeCorrelation);
+      if (optimizers->Length > 0)
+         grid.optimizers.clear();
+      for (Processing::TrainingOptimizer optimizer : optimizers)
+         grid.optimizers.push_back(static_cast<Processing::OptimizerType>(optimizer));
+      grid.folds = folds;
+      if (maxEpochs < 1)
+         throw ref new InvalidArgumentException();
+      grid.maxEpochs = maxEpochs;
+      return grid;
+   }
+
+   template <typename TData>
+   IVector<Processing::ModelEvaluation>^ ToEvaluations(const std::vector<Processing::ModelScore<TData>>& scores)
+   {
+      auto pevaluations = ref new Vector<Processing::ModelEvaluation, EvaluationEqual>();
+      for (const Processing::ModelScore<TData>& score : scores) {
+         Processing::ModelEvaluation evaluation;
+         evaluation.Cascade = score.config.type == Processing::ModelType::CascadeCorrelation;
+         evaluation.LayerSize = (int32)score.config.layerSize;
+         evaluation.LayerCount = (int32)score.config.layerCount;
+         evaluation.Optimizer = static_cast<Processing::TrainingOptimizer>(score.config.optimizer);
+         evaluation.Accuracy = score.accuracy;
+         evaluation.AccuracyDeviation = score.accuracyDeviation;
+         evaluation.TrainingSeconds = score.trainSeconds;
+         evaluation.LatencyMicroseconds = score.latencyMicroseconds;
+         pevaluations->Append(evaluation);
+      }
+      return pevaluations;
+   }
+}
 
 Processing::Single::Classifier::Classifier() : m_pc(ref new Processing::Classifier<float>())
 { }
@@ -32,6 +94,25 @@ void Processing::Single::Classifier::CreateCascadeNetwork(int32 inputSize, int32
    m_pc->CreateCCNetwork(inputSize, outputSize);
 }
 
+void Processing::Single::Classifier::CreateRandomForest(int32 inputSize, int32 outputSize, int32 treeCount, int32 maxDepth)
+{
+   if (treeCount < 1 || maxDepth < 0)
+      throw ref new InvalidArgumentException();
+   m_pc->CreateForest(inputSize, outputSize, treeCount, maxDepth);
+}
+
+void Processing::Single::Classifier::CreateShrinkageLda(int32 inputSize, int32 outputSize)
+{
+   m_pc->CreateLinear(inputSize, outputSize, LinearMethod::ShrinkageLda, 0);
+}
+
+void Processing::Single::Classifier::CreateLinearSvm(int32 inputSize, int32 outputSize, float64 cost)
+{
+   if (!(cost > 0))
+      throw ref new InvalidArgumentException();
+   m_pc->CreateLinear(inputSize, outputSize, LinearMethod::Svm, (float)cost);
+}
+
 void Processing::Single::Classifier::AddExample(const Array<float>^ trainingInput, const Array<float>^ trainingOutput)
 {
    m_pc->AddExample(trainingInput, trainingOutput);
@@ -42,6 +123,31 @@ IAsyncAction^ Processing::Single::Classifier::TrainAsync()
    return concurrency::create_async([this]() { m_pc->Train(); });   
 }
 
+IAsyncAction^ Processing::Single::Classifier::LearnAsync(const Array<float>^ trainingInput, const Array<float>^ trainingOutput)
+{
+   return concurrency::create_async([=]() { m_pc->Learn(trainingInput, trainingOutput); });
+}
+
+void Processing::Single::Classifier::ConfigureOnlineLearning(int32 stepsPerExample, int32 batchSize, float64 learningRate)
+{
+   if (stepsPerExample < 0 || batchSize < 1 || !(learningRate > 0))
+      throw ref new InvalidArgumentException();
+   m_pc->ConfigureOnlineLearning(stepsPerExample, batchSize, (float)learningRate);
+}
+
+void Processing::Single::Classifier::SetOptimizer(TrainingOptimizer optimizer)
+{
+   m_pc->SetOptimizer(static_cast<OptimizerType>(optimizer));
+}
+
+IAsyncOperation<IVector<Processing::ModelEvaluation>^>^ Processing::Single::Classifier::SelectModelAsync(
+   const Array<int32>^ layerSizes, const Array<int32>^ layerCounts, bool includeCascade, const Array<TrainingOptimizer>^ optimizers, int32 folds,
+   int32 maxEpochs)
+{
+   ModelGrid<float> grid = MakeGrid<float>(layerSizes, layerCounts, includeCascade, optimizers, folds, maxEpochs);
+   return concurrency::create_async([=]() { return ToEvaluations(m_pc->SelectModel(grid)); });
+}
+
 IAsyncAction^ Processing::Single::Classifier::ClassifyAsync(const Array<float>^ data, WriteOnlyArray<float>^ output)
 {
    return concurrency::create_async([=]() { m_pc->Classify(data, output); });   
@@ -52,6 +158,48 @@ void Processing::Single::Classifier::Classify(const Array<float>^ data, WriteOnl
    m_pc->Classify(data, output);
 }
 
+IAsyncAction^ Processing::Single::Classifier::ClassifyBatchAsync(const Array<float>^ data, WriteOnlyArray<float>^ output)
+{
+   return concurrency::create_async([=]() { m_pc->ClassifyBatch(data, output); });
+}
+
+void Processing::Single::Classifier::ClassifyBatch(const Array<float>^ data, WriteOnlyArray<float>^ output)
+{
+   m_pc->ClassifyBatch(data, output);
+}
+
+Processing::QuantizationReport Processing::Single::Classifier::Quantize()
+{
+   auto error = m_pc->Quantize();
+   Processing::QuantizationReport report;
+   report.MeanAbsoluteDelta = error.meanAbsDelta;
+   report.MaxAbsoluteDelta = error.maxAbsDelta;
+   report.Agreement = error.agreement;
+   report.FloatBytes = error.floatBytes;
+   report.QuantizedBytes = error.quantizedBytes;
+   return report;
+}
+
+void Processing::Single::Classifier::Dequantize()
+{
+   m_pc->Dequantize();
+}
+
+IAsyncAction^ Processing::Single::Classifier::SaveAsync(String^ path)
+{
+   return concurrency::create_async([=]() { m_pc->Save(path); });
+}
+
+IAsyncAction^ Processing::Single::Classifier::LoadAsync(String^ path)
+{
+   return concurrency::create_async([=]() { m_pc->Load(path); });
+}
+
+IAsyncAction^ Processing::Single::Classifier::SpillExamplesAsync(String^ path)
+{
+   return concurrency::create_async([=]() { m_pc->SpillExamples(path); });
+}
+
 
 Processing::Double::Classifier::Classifier() : m_pc(ref new Processing::Classifier<double>())
 { }
@@ -66,6 +214,25 @@ void Processing::Double::Classifier::CreateCascadeNetwork(int32 inputSize, int32
    m_pc->CreateCCNetwork(inputSize, outputSize);
 }
 
+void Processing::Double::Classifier::CreateRandomForest(int32 inputSize, int32 outputSize, int32 treeCount, int32 maxDepth)
+{
+   if (treeCount < 1 || maxDepth < 0)
+      throw ref new InvalidArgumentException();
+   m_pc->CreateForest(inputSize, outputSize, treeCount, maxDepth);
+}
+
+void Processing::Double::Classifier::CreateShrinkageLda(int32 inputSize, int32 outputSize)
+{
+   m_pc->CreateLinear(inputSize, outputSize, LinearMethod::ShrinkageLda, 0);
+}
+
+void Processing::Double::Classifier::CreateLinearSvm(int32 inputSize, int32 outputSize, float64 cost)
+{
+   if (!(cost > 0))
+      throw ref new InvalidArgumentException();
+   m_pc->CreateLinear(inputSize, outputSize, LinearMethod::Svm, cost);
+}
+
 void Processing::Double::Classifier::AddExample(const Array<double>^ trainingInput, const Array<double>^ trainingOutput)
 {
    m_pc->AddExample(trainingInput, trainingOutput);
@@ -76,6 +243,31 @@ IAsyncAction^ Processing::Double::Classifier::TrainAsync()
    return concurrency::create_async([this]() { m_pc->Train(); });
 }
 
+IAsyncAction^ Processing::Double::Classifier::LearnAsync(const Array<double>^ trainingInput, const Array<double>^ trainingOutput)
+{
+   return concurrency::create_async([=]() { m_pc->Learn(trainingInput, trainingOutput); });
+}
+
+void Processing::Double::Classifier::ConfigureOnlineLearning(int32 stepsPerExample, int32 batchSize, float64 learningRate)
+{
+   if (stepsPerExample < 0 || batchSize < 1 || !(learningRate > 0))
+      throw ref new InvalidArgumentException();
+   m_pc->ConfigureOnlineLearning(stepsPerExample, batchSize, (double)learningRate);
+}
+
+void Processing::Double::Classifier::SetOptimizer(TrainingOptimizer optimizer)
+{
+   m_pc->SetOptimizer(static_cast<OptimizerType>(optimizer));
+}
+
+IAsyncOperation<IVector<Processing::ModelEvaluation>^>^ Processing::Double::Classifier::SelectModelAsync(
+   const Array<int32>^ layerSizes, const Array<int32>^ layerCounts, bool includeCascade, const Array<TrainingOptimizer>^ optimizers, int32 folds,
+   int32 maxEpochs)
+{
+   ModelGrid<double> grid = MakeGrid<double>(layerSizes, layerCounts, includeCascade, optimizers, folds, maxEpochs);
+   return concurrency::create_async([=]() { return ToEvaluations(m_pc->SelectModel(grid)); });
+}
+
 IAsyncAction^ Processing::Double::Classifier::ClassifyAsync(const Array<double>^ data, WriteOnlyArray<double>^ output)
 {
    return concurrency::create_async([=]() { m_pc->Classify(data, output); });
@@ -85,3 +277,45 @@ void Processing::Double::Classifier::Classify(const Array<double>^ data, WriteOn
 {
    m_pc->Classify(data, output);
 }
+
+IAsyncAction^ Processing::Double::Classifier::ClassifyBatchAsync(const Array<double>^ data, WriteOnlyArray<double>^ output)
+{
+   return concurrency::create_async([=]() { m_pc->ClassifyBatch(data, output); });
+}
+
+void Processing::Double::Classifier::ClassifyBatch(const Array<double>^ data, WriteOnlyArray<double>^ output)
+{
+   m_pc->ClassifyBatch(data, output);
+}
+
+Processing::QuantizationReport Processing::Double::Classifier::Quantize()
+{
+   auto error = m_pc->Quantize();
+   Processing::QuantizationReport report;
+   report.MeanAbsoluteDelta = error.meanAbsDelta;
+   report.MaxAbsoluteDelta = error.maxAbsDelta;
+   report.Agreement = error.agreement;
+   report.FloatBytes = error.floatBytes;
+   report.QuantizedBytes = error.quantizedBytes;
+   return report;
+}
+
+void Processing::Double::Classifier::Dequantize()
+{
+   m_pc->Dequantize();
+}
+
+IAsyncAction^ Processing::Double::Classifier::SaveAsync(String^ path)
+{
+   return concurrency::create_async([=]() { m_pc->Save(path); });
+}
+
+IAsyncAction^ Processing::Double::Classifier::LoadAsync(String^ path)
+{
+   return concurrency::create_async([=]() { m_pc->Load(path); });
+}
+
+IAsyncAction^ Processing::Double::Classifier::SpillExamplesAsync(String^ path)
+{
+   return concurrency::create_async([=]() { m_pc->SpillExamples(path); });
+}
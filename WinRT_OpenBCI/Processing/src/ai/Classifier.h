@@ -15,6 +15,7 @@
 */
 #pragma once
 using namespace Windows::Foundation;
+using namespace Windows::Foundation::Collections;
 using namespace Platform;
 
 namespace Processing
@@ -22,6 +23,92 @@ namespace Processing
    template<typename TData>
    ref class Classifier;
 
+   /// <summary>
+   /// Deviation of a quantized classifier from its floating-point model over the training examples
+   /// </summary>
+   public value struct QuantizationReport
+   {
+      /// <summary>
+      /// Mean absolute output difference
+      /// </summary>
+      float64 MeanAbsoluteDelta;
+      /// <summary>
+      /// Largest absolute output difference
+      /// </summary>
+      float64 MaxAbsoluteDelta;
+      /// <summary>
+      /// Fraction of examples for which both models pick the same output
+      /// </summary>
+      float64 Agreement;
+      /// <summary>
+      /// Bytes of weights and biases of the floating-point model
+      /// </summary>
+      uint64 FloatBytes;
+      /// <summary>
+      /// Bytes of weights, biases and precomputed offsets of the quantized model
+      /// </summary>
+      uint64 QuantizedBytes;
+   };
+
+   /// <summary>
+   /// Weight update rule used by training
+   /// </summary>
+   public enum class TrainingOptimizer
+   {
+      /// <summary>
+      /// Plain gradient steps with a decaying learning rate
+      /// </summary>
+      GradientDescent,
+      /// <summary>
+      /// Resilient propagation, one step per epoch
+      /// </summary>
+      Rprop,
+      /// <summary>
+      /// Fahlman's quick propagation, one step per epoch
+      /// </summary>
+      Quickprop,
+      /// <summary>
+      /// Adaptive moment estimation on mini-batches
+      /// </summary>
+      Adam
+   };
+
+   /// <summary>
+   /// Cross-validated performance of one network configuration
+   /// </summary>
+   public value struct ModelEvaluation
+   {
+      /// <summary>
+      /// Cascade-correlation network if true, otherwise a fixed-size network
+      /// </summary>
+      bool Cascade;
+      /// <summary>
+      /// Nodes per hidden layer of a fixed-size network
+      /// </summary>
+      int32 LayerSize;
+      /// <summary>
+      /// Layers of a fixed-size network, output layer included
+      /// </summary>
+      int32 LayerCount;
+      TrainingOptimizer Optimizer;
+      /// <summary>
+      /// Mean fraction of correctly classified held-out examples over the folds
+      /// </summary>
+      float64 Accuracy;
+      /// <summary>
+      /// Standard deviation of the accuracy over the folds
+      /// </summary>
+      float64 AccuracyDeviation;
+      /// <summary>
+      /// Mean training time per fold
+      /// </summary>
+      float64 TrainingSeconds;
+      /// <summary>
+      /// Mean classification time per example
+      /// </summary>
+      float64 LatencyMicroseconds;
+   };
+
    namespace Single
    {
       /// <summary>
@@ -38,13 +125,88 @@ namespace Processing
 
          void CreateCascadeNetwork(int32 inputSize, int32 outputSize);
 
+         /// <summary>
+         /// Random forest instead of a network, trained by TrainAsync and used by the Classify methods like one.
+         /// Not supported by LearnAsync, Quantize and SaveAsync.
+         /// </summary>
+         void CreateRandomForest(int32 inputSize, int32 outputSize, int32 treeCount, int32 maxDepth);
+
+         /// <summary>
+         /// Linear discriminant analysis with a shrunk covariance estimate. Trains in closed form in milliseconds,
+         /// e.g. to recalibrate every session. Outputs are class posteriors. Not supported by LearnAsync, Quantize and SaveAsync.
+         /// </summary>
+         void CreateShrinkageLda(int32 inputSize, int32 outputSize);
+
+         /// <summary>
+         /// One-vs-rest linear SVMs, cost weighs training errors against the margin (1 is a common start).
+         /// Not supported by LearnAsync, Quantize and SaveAsync.
+         /// </summary>
+         void CreateLinearSvm(int32 inputSize, int32 outputSize, float64 cost);
+
          void AddExample(const Array<float>^ trainingInput, const Array<float>^ trainingOutput);
 
          IAsyncAction^ TrainAsync();
 
+         /// <summary>
+         /// Adds a training example and immediately adapts the network to it with a few gradient steps,
+         /// rehearsing recent examples. Far cheaper than TrainAsync, which still fits all examples.
+         /// Uses Adam if that is the selected optimizer and gradient descent otherwise, RPROP and Quickprop need full batches.
+         /// </summary>
+         IAsyncAction^ LearnAsync(const Array<float>^ trainingInput, const Array<float>^ trainingOutput);
+
+         /// <summary>
+         /// Steps per learned example (4 by default), examples per step including the new one (8) and the learning rate (0.1)
+         /// </summary>
+         void ConfigureOnlineLearning(int32 stepsPerExample, int32 batchSize, float64 learningRate);
+
+         /// <summary>
+         /// Selects the weight update rule for subsequent trainings, gradient descent by default
+         /// </summary>
+         void SetOptimizer(TrainingOptimizer optimizer);
+
+         /// <summary>
+         /// k-fold cross-validation of every combination of the given topologies and optimizers on the stored examples,
+         /// run concurrently. The best configuration is trained on all examples and replaces the network.
+         /// Every training stops after maxEpochs epochs at the latest.
+         /// </summary>
+         IAsyncOperation<IVector<ModelEvaluation>^>^ SelectModelAsync(const Array<int32>^ layerSizes, const Array<int32>^ layerCounts,
+                                                                      bool includeCascade, const Array<TrainingOptimizer>^ optimizers, int32 folds,
+                                                                      int32 maxEpochs);
+
          IAsyncAction^ ClassifyAsync(const Array<float>^ data, WriteOnlyArray<float>^ output);
 
          void Classify(const Array<float>^ data, WriteOnlyArray<float>^ output);
+
+         /// <summary>
+         /// Classifies data.Length / inputSize examples at once. data is row-major [example][input],
+         /// output receives [example][output].
+         /// </summary>
+         IAsyncAction^ ClassifyBatchAsync(const Array<float>^ data, WriteOnlyArray<float>^ output);
+
+         void ClassifyBatch(const Array<float>^ data, WriteOnlyArray<float>^ output);
+
+         /// <summary>
+         /// Classifies with an int8 export of the network from now on, including after further training
+         /// </summary>
+         QuantizationReport Quantize();
+
+         void Dequantize();
+
+         /// <summary>
+         /// Writes the network to a versioned binary model file
+         /// </summary>
+         IAsyncAction^ SaveAsync(String^ path);
+
+         /// <summary>
+         /// Replaces the network with one from a model file. Fixed-size networks are mapped into memory and used in place.
+         /// </summary>
+         IAsyncAction^ LoadAsync(String^ path);
+
+         /// <summary>
+         /// Moves the stored training examples, and those added later, to a memory-mapped scratch file at path.
+         /// The file is deleted when the classifier is destroyed.
+         /// </summary>
+         IAsyncAction^ SpillExamplesAsync(String^ path);
       };
    }
 
@@ -64,13 +226,88 @@ namespace Processing
 
          void CreateCascadeNetwork(int32 inputSize, int32 outputSize);
 
+         /// <summary>
+         /// Random forest instead of a network, trained by TrainAsync and used by the Classify methods like one.
+         /// Not supported by LearnAsync, Quantize and SaveAsync.
+         /// </summary>
+         void CreateRandomForest(int32 inputSize, int32 outputSize, int32 treeCount, int32 maxDepth);
+
+         /// <summary>
+         /// Linear discriminant analysis with a shrunk covariance estimate. Trains in closed form in milliseconds,
+         /// e.g. to recalibrate every session. Outputs are class posteriors. Not supported by LearnAsync, Quantize and SaveAsync.
+         /// </summary>
+         void CreateShrinkageLda(int32 inputSize, int32 outputSize);
+
+         /// <summary>
+         /// One-vs-rest linear SVMs, cost weighs training errors against the margin (1 is a common start).
+         /// Not supported by LearnAsync, Quantize and SaveAsync.
+         /// </summary>
+         void CreateLinearSvm(int32 inputSize, int32 outputSize, float64 cost);
+
          void AddExample(const Array<double>^ trainingInput, const Array<double>^ trainingOutput);
 
          IAsyncAction^ TrainAsync();
 
+         /// <summary>
+         /// Adds a training example and immediately adapts the network to it with a few gradient steps,
+         /// rehearsing recent examples. Far cheaper than TrainAsync, which still fits all examples.
+         /// Uses Adam if that is the selected optimizer and gradient descent otherwise, RPROP and Quickprop need full batches.
+         /// </summary>
+         IAsyncAction^ LearnAsync(const Array<double>^ trainingInput, const Array<double>^ trainingOutput);
+
+         /// <summary>
+         /// Steps per learned example (4 by default), examples per step including the new one (8) and the learning rate (0.1)
+         /// </summary>
+         void ConfigureOnlineLearning(int32 stepsPerExample, int32 batchSize, float64 learningRate);
+
+         /// <summary>
+         /// Selects the weight update rule for subsequent trainings, gradient descent by default
+         /// </summary>
+         void SetOptimizer(TrainingOptimizer optimizer);
+
+         /// <summary>
+         /// k-fold cross-validation of every combination of the given topologies and optimizers on the stored examples,
+         /// run concurrently. The best configuration is trained on all examples and replaces the network.
+         /// Every training stops after maxEpochs epochs at the latest.
+         /// </summary>
+         IAsyncOperation<IVector<ModelEvaluation>^>^ SelectModelAsync(const Array<int32>^ layerSizes, const Array<int32>^ layerCounts,
+                                                                      bool includeCascade, const Array<TrainingOptimizer>^ optimizers, int32 folds,
+                                                                      int32 maxEpochs);
+
          IAsyncAction^ ClassifyAsync(const Array<double>^ data, WriteOnlyArray<double>^ output);
 
          void Classify(const Array<double>^ data, WriteOnlyArray<double>^ output);
+
+         /// <summary>
+         /// Classifies data.Length / inputSize examples at once. data is row-major [example][input],
+         /// output receives [example][output].
+         /// </summary>
+         IAsyncAction^ ClassifyBatchAsync(const Array<double>^ data, WriteOnlyArray<double>^ output);
+
+         void ClassifyBatch(const Array<double>^ data, WriteOnlyArray<double>^ output);
+
+         /// <summary>
+         /// Classifies with an int8 export of the network from now on, including after further training
+         /// </summary>
+         QuantizationReport Quantize();
+
+         void Dequantize();
+
+         /// <summary>
+         /// Writes the network to a versioned binary model file
+         /// </summary>
+         IAsyncAction^ SaveAsync(String^ path);
+
+         /// <summary>
+         /// Replaces the network with one from a model file. Fixed-size networks are mapped into memory and used in place.
+         /// </summary>
+         IAsyncAction^ LoadAsync(String^ path);
+
+         /// <summary>
+         /// Moves the stored training examples, and those added later, to a memory-mapped scratch file at path.
+         /// The file is deleted when the classifier is destroyed.
+         /// </summary>
+         IAsyncAction^ SpillExamplesAsync(String^ path);
       };
    }
 
@@ -0,0 +1,299 @@
+/*
+*    Copyright 2017 Mikhail Vasilyev
+*
+*    Licensed under the Apache License, Version 2.0 (the "License");
+*    you may not use this file except in compliance with the License.
+*    You may obtain a copy of the License at
+*
+*        http://www.apache.org/licenses/LICENSE-2.0
+*
+*    Unless required by applicable law or agreed to in writing, software
+*    distributed under the License is distributed on an "AS IS" BASIS,
+*    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+*    See the License for the specific language governing permissions and
+*    limitations under the License.
+*/
+#pragma once
+#include <vector>
+#include <memory>
+#include <new>
+#include <algorithm>
+#include <cmath>
+#include <cassert>
+#include <type_traits>
+#include "ModelFile.h"
+#include "../simd/Simd.h"
+
+#ifndef OUT
+ #define OUT
+#endif
+
+namespace Processing
+{
+   /// <summary>
+   /// Scratch file that grows in mapped read-write views. It is deleted once closed
+   /// and the last view is unmapped, so it never outlives the process.
+   /// </summary>
+   class ScratchFile final
+   {
+#ifdef _WIN32
+      HANDLE m_file = INVALID_HANDLE_VALUE;
+#else
+      int m_fd = -1;
+      uint64_t m_size = 0;
+#endif
+
+   public:
+      // view offsets must be multiples of this, the allocation granularity on Windows
+      static constexpr size_t GRANULARITY = 64 * 1024;
+
+      explicit ScratchFile(const MappedFile::PathChar *path)
+      {
+#ifdef _WIN32
+         CREATEFILE2_EXTENDED_PARAMETERS params = { sizeof(params) };
+         params.dwFileAttributes = FILE_ATTRIBUTE_TEMPORARY;
+         params.dwFileFlags = FILE_FLAG_DELETE_ON_CLOSE;
+         m_file = CreateFile2(path, GENERIC_READ | GENERIC_WRITE, 0, CREATE_ALWAYS, &params);
+         if (m_file == INVALID_HANDLE_VALUE)
+            throw std::runtime_error("cannot create the scratch file");
+#else
+         m_fd = open(path, O_RDWR | O_CREAT | O_TRUNC, 0600);
+         if (m_fd < 0)
+            throw std::runtime_error("cannot create the scratch file");
+         unlink(path);
+#endif
+      }
+      ScratchFile(const ScratchFile&) = delete;
+      ScratchFile& operator =(const ScratchFile&) = delete;
+      ~ScratchFile()
+      {
+#ifdef _WIN32
+         CloseHandle(m_file);
+#else
+         close(m_fd);
+#endif
+      }
+      // Extends the file as needed and maps [offset, offset + bytes)
+      void *Map(uint64_t offset, size_t bytes)
+      {
+         assert(offset % GRANULARITY == 0);
+         void *pview = nullptr;
+#ifdef _WIN32
+         // a mapping larger than the file extends it; the view keeps the mapping object alive
+         HANDLE mapping = CreateFileMappingFromApp(m_file, nullptr, PAGE_READWRITE, offset + bytes, nullptr);
+         if (mapping) {
+            pview = MapViewOfFileFromApp(mapping, FILE_MAP_WRITE, offset, bytes);
+            CloseHandle(mapping);
+         }
+#else
+         if (offset + bytes > m_size) {
+            if (ftruncate(m_fd, (off_t)(offset + bytes)) != 0)
+               throw std::runtime_error("cannot extend the scratch file");
+            m_size = offset + bytes;
+         }
+         pview = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, m_fd, (off_t)offset);
+         if (pview == MAP_FAILED)
+            pview = nullptr;
+#endif
+         if (!pview)
+            throw std::runtime_error("cannot map the scratch file");
+         return pview;
+      }
+      static void Unmap(void *pview, size_t bytes) noexcept
+      {
+#ifdef _WIN32
+         UnmapViewOfFile(pview);
+#else
+         munmap(pview, bytes);
+#endif
+      }
+   };
+
+   /// <summary>
+   /// Training examples in row-major [example][value] blocks of a fixed number of rows. Rows start
+   /// on MODEL_ALIGNMENT boundaries and never move, so appending doesn't copy what is already stored.
+   /// A copy shares the full blocks with the original and is cheap to take; both can be appended to.
+   /// </summary>
+   template <typename TData>
+   class Dataset final
+   {
+      static_assert(std::is_floating_point_v<TData>, "");
+      typedef Pack<TData> P;
+
+      static constexpr size_t CHUNK_BYTES = 1024 * 1024; // per block at least, unless a single row is larger
+
+      size_t m_inputCount, m_outputCount;
+      size_t m_inStride, m_outStride;     // row lengths incl. padding
+      size_t m_chunkRows, m_chunkLength;  // rows and TData values per block
+      InputNormalization m_normalization;
+      size_t m_count;
+
+      // each block: inputs [row][m_inStride], outputs [row][m_outStride]
+      std::vector<std::shared_ptr<TData>> m_chunks;
+      std::shared_ptr<ScratchFile> m_pspill; // where new blocks go, null for the heap
+
+   public:
+      Dataset() : Dataset(0, 0)
+      { }
+      // PerExample normalization is what Classifier applies to everything it classifies
+      Dataset(size_t inputCount, size_t outputCount, InputNormalization normalization = InputNormalization::PerExample)
+         : m_inputCount(inputCount), m_outputCount(outputCount),
+         m_inStride(AlignedCount<TData>(inputCount)), m_outStride(AlignedCount<TData>(outputCount)),
+         m_normalization(normalization), m_count(0)
+      {
+         const size_t rowBytes = (m_inStride + m_outStride) * sizeof(TData);
+         const size_t bytes = std::max(CHUNK_BYTES, rowBytes);
+         m_chunkRows = bytes / rowBytes;
+         // whole scratch file views, padded to keep every block aligned
+         m_chunkLength = (m_chunkRows * rowBytes + ScratchFile::GRANULARITY - 1) / ScratchFile::GRANULARITY * ScratchFile::GRANULARITY
+                         / sizeof(TData);
+      }
+      // The full blocks are shared, the partially filled last one is copied to the heap
+      Dataset(const Dataset& other)
+         : m_inputCount(other.m_inputCount), m_outputCount(other.m_outputCount), m_inStride(other.m_inStride), m_outStride(other.m_outStride),
+         m_chunkRows(other.m_chunkRows), m_chunkLength(other.m_chunkLength), m_normalization(other.m_normalization),
+         m_count(other.m_count), m_chunks(other.m_chunks), m_pspill(nullptr)
+      {
+         if (const size_t rows = m_count % m_chunkRows) {
+            const TData *psrc = m_chunks.back().get();
+            std::shared_ptr<TData> ptail = AllocateChunk(m_chunks.size() - 1);
+            std::copy(psrc, psrc + rows * m_inStride, ptail.get());
+            std::copy(OutputsOf(psrc), OutputsOf(psrc) + rows * m_outStride, OutputsOf(ptail.get()));
+            m_chunks.back() = std::move(ptail);
+         }
+      }
+      Dataset(Dataset&&) = default;
+      Dataset& operator =(const Dataset& other)
+      {
+         return *this = Dataset(other);
+      }
+      Dataset& operator =(Dataset&&) = default;
+
+      size_t GetCount() const noexcept
+      {
+         return m_count;
+      }
+      size_t GetInputCount() const noexcept
+      {
+         return m_inputCount;
+      }
+      size_t GetOutputCount() const noexcept
+      {
+         return m_outputCount;
+      }
+      // normalized as configured
+      const TData *GetInput(size_t ex) const
+      {
+         assert(ex < m_count);
+         return m_chunks[ex / m_chunkRows].get() + (ex % m_chunkRows) * m_inStride;
+      }
+      const TData *GetOutput(size_t ex) const
+      {
+         assert(ex < m_count);
+         return OutputsOf(m_chunks[ex / m_chunkRows].get()) + (ex % m_chunkRows) * m_outStride;
+      }
+      // row pointers of all examples, appended, as the trainers take them
+      void GetRows(OUT std::vector<const TData *> *pinputs, OUT std::vector<const TData *> *poutputs) const
+      {
+         pinputs->reserve(pinputs->size() + m_count);
+         poutputs->reserve(poutputs->size() + m_count);
+         for (size_t ex = 0; ex < m_count; ++ex) {
+            pinputs->push_back(GetInput(ex));
+            poutputs->push_back(GetOutput(ex));
+         }
+      }
+      // Copies the example in and normalizes the stored input
+      void Add(const TData *pinput, const TData *poutput)
+      {
+         if (m_count == m_chunks.size() * m_chunkRows)
+            m_chunks.push_back(AllocateChunk(m_chunks.size()));
+
+         TData *pchunk = m_chunks.back().get();
+         const size_t row = m_count % m_chunkRows;
+         TData *pin = pchunk + row * m_inStride;
+         std::copy(pinput, pinput + m_inputCount, pin);
+         std::copy(poutput, poutput + m_outputCount, OutputsOf(pchunk) + row * m_outStride);
+
+         if (m_normalization == InputNormalization::PerExample)
+            Normalize(pin, m_inputCount);
+         m_count++;
+      }
+      // Moves the examples to a scratch file at path, and every example added later as well.
+      // Memory use then stays flat however many examples there are; pages are loaded as training touches them.
+      void SpillTo(const MappedFile::PathChar *path)
+      {
+         auto pfile = std::make_shared<ScratchFile>(path);
+         std::vector<std::shared_ptr<TData>> chunks;
+         for (size_t c = 0; c < m_chunks.size(); ++c) {
+            chunks.push_back(MapChunk(pfile, c));
+            std::copy(m_chunks[c].get(), m_chunks[c].get() + m_chunkLength, chunks.back().get());
+         }
+         m_chunks.swap(chunks);
+         m_pspill = std::move(pfile);
+      }
+
+      // Zero mean and unit sample standard deviation, in place
+      static void Normalize(TData *data, size_t n)
+      {
+         const size_t packed = n / P::Width * P::Width;
+
+         P acc((TData)0.0);
+         for (size_t i = 0; i < packed; i += P::Width)
+            acc = acc + P::Load(data + i);
+         TData sum = acc.Sum();
+         for (size_t i = packed; i < n; ++i)
+            sum += data[i];
+         const TData mean = sum / n;
+
+         const P vmean(mean);
+         acc = P((TData)0.0);
+         for (size_t i = 0; i < packed; i += P::Width) {
+            P dev = P::Load(data + i) - vmean;
+            acc = acc + dev * dev;
+         }
+         TData sq = acc.Sum();
+         for (size_t i = packed; i < n; ++i)
+            sq += (data[i] - mean) * (data[i] - mean);
+         const TData sd = std::sqrt(sq / (n - 1));
+
+         const TData scale = (TData)1.0 / sd;
+         const P vscale(scale);
+         for (size_t i = 0; i < packed; i += P::Width)
+            ((P::Load(data + i) - vmean) * vscale).Store(data + i);
+         for (size_t i = packed; i < n; ++i)
+            data[i] = (data[i] - mean) * scale;
+      }
+
+   private:
+      TData *OutputsOf(TData *pchunk) const noexcept
+      {
+         return pchunk + m_chunkRows * m_inStride;
+      }
+      const TData *OutputsOf(const TData *pchunk) const noexcept
+      {
+         return pchunk + m_chunkRows * m_inStride;
+      }
+      // zeroed, so that the padding is too
+      std::shared_ptr<TData> AllocateChunk(size_t index) const
+      {
+         if (m_pspill)
+            return MapChunk(m_pspill, index); // extending the file zero-fills
+
+         const size_t bytes = m_chunkLength * sizeof(TData);
+         TData *p = static_cast<TData *>(::operator new(bytes, std::align_val_t(MODEL_ALIGNMENT)));
+         std::fill(p, p + m_chunkLength, (TData)0.0);
+         return std::shared_ptr<TData>(p, [](TData *p) {
+            ::operator delete(p, std::align_val_t(MODEL_ALIGNMENT));
+         });
+      }
+      // the view holds on to the file
+      std::shared_ptr<TData> MapChunk(const std::shared_ptr<ScratchFile>& pfile, size_t index) const
+      {
+         const size_t bytes = m_chunkLength * sizeof(TData);
+         TData *p = static_cast<TData *>(pfile->Map((uint64_t)index * bytes, bytes));
+         return std::shared_ptr<TData>(p, [pfile, bytes](TData *p) {
+            ScratchFile::Unmap(p, bytes);
+         });
+      }
+   };
+}
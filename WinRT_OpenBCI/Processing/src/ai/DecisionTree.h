@@ -14,95 +14,321 @@
 *    limitations under the License.
 */
 #pragma once
-#if 0
+#include <vector>
 #include <algorithm>
+#include <numeric>
+#include <random>
+#include <cmath>
+#include <cstdint>
+#include <cassert>
+#include <stdexcept>
 #include <type_traits>
-#include <utility>
-#include <memory>
 
+#ifndef OUT
+ #define OUT
+#endif
 
 namespace Processing
 {
-   // Attribute in a decision tree
-   template <typename TVal, typename TId, typename TImp>
-   class IAttribute
+   struct ForestParams
    {
-   public:
-      typedef TVal Val_t;
-      typedef TId Id_t;
-      typedef TImp Imp_t;
-      typedef IAttribute<TVal, TId, TImp> My_t;
-
-      virtual ~IAttribute() { }
+      size_t treeCount = 64;
+      size_t maxDepth = 12;          // the root is at depth 0
+      size_t minLeafSize = 2;        // in bootstrap draws
+      size_t featuresPerSplit = 0;   // 0 for the square root of the input count
+      uint32_t seed = 0;
+   };
 
-      virtual Id_t GetId() const noexcept = 0;
+   /// <summary>
+   /// Random forest of multi-output regression trees: every leaf holds the mean output vector of its
+   /// bootstrap examples, and the forest averages the leaves it reaches. With one-hot outputs, splits
+   /// minimize the Gini impurity and the result approximates class probabilities.
+   /// </summary>
+   template <typename TData>
+   class RandomForest final
+   {
+      static_assert(std::is_floating_point_v<TData>, "");
 
-      virtual size_t GetValuesCount() const noexcept = 0;
+      static constexpr uint32_t LEAF = UINT32_MAX;
 
-      virtual Val_t GetValueAt(size_t index) const = 0;
+      size_t m_inputCount, m_outputCount;
 
-      virtual Imp_t GetImportance() const = 0;
-   };
+      // Nodes of all trees, each tree breadth-first from its root, so the top levels of a tree share cache lines
+      std::vector<uint32_t> m_features;  // split input, LEAF for leaves
+      std::vector<TData> m_thresholds;   // inputs above the threshold go right
+      std::vector<uint32_t> m_children;  // left child, the right one follows it; for leaves the offset into m_leafValues
+      std::vector<TData> m_leafValues;   // [leaf][output]
+      std::vector<uint32_t> m_roots;     // [tree]
 
-   template <typename TData, REQUIRES_FLOAT(TData)>
-   using IContAttribute = IAttribute<std::pair<TData, TData>, TData, TData>;
-
-   template <typename TData>
-   class ContAttribute : public IContAttribute<TData>
-   {
-      typedef IContAttribute<TData> Base_t;
-      typedef typename Base_t::Val_t Val_t;
-      typedef typename Base_t::Id_t Id_t;
-      typedef typename Base_t::Imp_t Imp_t;
+      // Training data shared by all trees
+      struct Columns
+      {
+         size_t exCount;
+         std::vector<TData> values;    // [input][ex]
+         std::vector<uint32_t> order;  // [input][rank], examples by ascending value
+         std::vector<TData> outputs;   // [ex][output]
+      };
 
-      Id_t m_id;
-      std::shared_ptr<std::vector<TData>> m_pSplit;
-      std::function<Imp_t(Id_t)> m_GetImp; // returns importance for the given attribute
+      // one tree as it is grown, indices local to it
+      struct Tree
+      {
+         std::vector<uint32_t> features;
+         std::vector<TData> thresholds;
+         std::vector<uint32_t> children;
+         std::vector<TData> leafValues;
+      };
 
    public:
-      template <typename F>
-      ContAttribute(Id_t id, std::shared_ptr<std::vector<TData>> psplit, F&& GetImp)
-         : m_id(id), m_pSplit(std::move(psplit)), m_GetImp(std::forward<F>(GetImp))
+      RandomForest(size_t inputCount, size_t outputCount) : m_inputCount(inputCount), m_outputCount(outputCount)
       { }
-      virtual Id_t GetId() const noexcept
+      size_t GetInputCount() const noexcept
       {
-         return m_id;
+         return m_inputCount;
       }
-      virtual size_t GetValuesCount() const noexcept
+      size_t GetOutputCount() const noexcept
       {
-         return m_pSplit->size() + 1;
+         return m_outputCount;
       }
-      virtual Val_t GetValueAt(size_t index) const
+      size_t GetTreeCount() const noexcept
       {
-         return std::make_pair(m_pSplit->operator[](index), m_pSplit->operator[](index + 1));
+         return m_roots.size();
       }
-      size_t GetIndexOf(TData val)
+      size_t GetNodeCount() const noexcept
       {
-         auto it = std::upper_bound(m_pSplit->cbegin(), m_pSplit->cend(), val);
-         return std::distance(m_pSplit->cbegin(), it);
+         return m_features.size();
       }
-      virtual Imp_t GetImportance() const
+      // Replaces the trees. Every input column is sorted once, the trees are then grown concurrently
+      // and only partition the sorted columns, level by level.
+      void Fit(const std::vector<const TData *>& inputs, const std::vector<const TData *>& outputs, const ForestParams& params)
       {
-         return m_GetImp(m_id);
+         if (inputs.empty() || inputs.size() != outputs.size() || params.treeCount == 0)
+            throw std::invalid_argument("no examples or no trees");
+         if (inputs.size() >= LEAF)
+            throw std::invalid_argument("too many examples");
+
+         const Columns columns = Presort(inputs, outputs);
+         std::vector<Tree> trees(params.treeCount);
+         concurrency::parallel_for((size_t)0, trees.size(), [&](size_t t) {
+            trees[t] = GrowTree(columns, params, params.seed + (uint32_t)t);
+         });
+
+         m_features.clear();
+         m_thresholds.clear();
+         m_children.clear();
+         m_leafValues.clear();
+         m_roots.clear();
+         for (const Tree& tree : trees) {
+            const uint32_t nodeBase = (uint32_t)m_features.size(), leafBase = (uint32_t)m_leafValues.size();
+            m_roots.push_back(nodeBase);
+            for (size_t node = 0; node < tree.features.size(); ++node) {
+               m_features.push_back(tree.features[node]);
+               m_thresholds.push_back(tree.thresholds[node]);
+               m_children.push_back(tree.children[node] + (tree.features[node] == LEAF ? leafBase : nodeBase));
+            }
+            m_leafValues.insert(m_leafValues.end(), tree.leafValues.cbegin(), tree.leafValues.cend());
+         }
+      }
+      void Predict(const TData *pinput, OUT TData *poutput) const
+      {
+         std::fill(poutput, poutput + m_outputCount, (TData)0.0);
+         for (uint32_t root : m_roots)
+            AddLeaf(m_leafValues.data() + m_children[FindLeaf(root, pinput)], poutput);
+         Scale(poutput);
+      }
+      // row-major [example][input] in and [example][output] out; tree by tree, so that each stays in cache
+      void PredictBatch(const TData *pinputs, size_t count, OUT TData *poutputs) const
+      {
+         std::fill(poutputs, poutputs + count * m_outputCount, (TData)0.0);
+         for (uint32_t root : m_roots) {
+            for (size_t ex = 0; ex < count; ++ex)
+               AddLeaf(m_leafValues.data() + m_children[FindLeaf(root, pinputs + ex * m_inputCount)], poutputs + ex * m_outputCount);
+         }
+         for (size_t ex = 0; ex < count; ++ex)
+            Scale(poutputs + ex * m_outputCount);
       }
-   };
 
-   template <typename TAttribute>
-   class TreeNode;
+   private:
+      uint32_t FindLeaf(uint32_t node, const TData *pinput) const
+      {
+         for (uint32_t feature; (feature = m_features[node]) != LEAF;)
+            node = m_children[node] + (pinput[feature] > m_thresholds[node]);
+         return node;
+      }
+      void AddLeaf(const TData *pleaf, TData *poutput) const
+      {
+         for (size_t i = 0; i < m_outputCount; ++i)
+            poutput[i] += pleaf[i];
+      }
+      void Scale(TData *poutput) const
+      {
+         if (m_roots.empty())
+            return;
+         const TData scale = (TData)1.0 / m_roots.size();
+         for (size_t i = 0; i < m_outputCount; ++i)
+            poutput[i] *= scale;
+      }
+      Columns Presort(const std::vector<const TData *>& inputs, const std::vector<const TData *>& outputs) const
+      {
+         const size_t exCount = inputs.size();
+         Columns columns = { exCount };
+         columns.values.resize(m_inputCount * exCount);
+         columns.order.resize(m_inputCount * exCount);
+         columns.outputs.resize(exCount * m_outputCount);
+         for (size_t ex = 0; ex < exCount; ++ex)
+            std::copy(outputs[ex], outputs[ex] + m_outputCount, &columns.outputs[ex * m_outputCount]);
 
-   template <typename TVal, typename TId, typename TImp>
-   class TreeNode<IAttribute<TVal, TId, TImp>>
-   {
-      typedef IAttribute<TVal, TId, TImp> Attr_t;
-      typedef TreeNode<IAttribute<TVal, TId, TImp>> My_t;
+         concurrency::parallel_for((size_t)0, m_inputCount, [&](size_t input) {
+            TData *pvalues = &columns.values[input * exCount];
+            for (size_t ex = 0; ex < exCount; ++ex)
+               pvalues[ex] = inputs[ex][input];
+            uint32_t *porder = &columns.order[input * exCount];
+            std::iota(porder, porder + exCount, 0);
+            std::sort(porder, porder + exCount, [pvalues](uint32_t a, uint32_t b) { return pvalues[a] < pvalues[b]; });
+         });
+         return columns;
+      }
+      // Breadth-first growth on a bootstrap sample. All nodes of a level occupy disjoint ranges of the
+      // per-input example lists, which stay sorted as they are partitioned.
+      Tree GrowTree(const Columns& columns, const ForestParams& params, uint32_t seed) const
+      {
+         const size_t exCount = columns.exCount, outN = m_outputCount;
+         const size_t mtry = std::min(m_inputCount, params.featuresPerSplit ? params.featuresPerSplit
+                                                                            : std::max<size_t>(1, (size_t)std::sqrt((double)m_inputCount)));
+         const TData minLeaf = (TData)std::max<size_t>(params.minLeafSize, 1);
+         std::mt19937 engine(seed);
 
-      std::shared_ptr<Attr_t> m_pAttr;
+         // bootstrap: draw counts serve as example weights, examples never drawn are left out
+         std::vector<TData> weights(exCount, (TData)0.0);
+         std::uniform_int_distribution<size_t> draw(0, exCount - 1);
+         for (size_t n = 0; n < exCount; ++n)
+            weights[draw(engine)] += 1;
 
-   public:
-      TreeNode(std::shared_ptr<Attr_t> pattr) : m_pAttr(std::move(pAttr)), Children(pattr->GetValuesCount())
-      { }
-      std::vector<std::unique_ptr<My_t>> Children;
-   };
+         std::vector<uint32_t> sorted;
+         for (size_t input = 0; input < m_inputCount; ++input) {
+            const uint32_t *porder = &columns.order[input * exCount];
+            for (size_t rank = 0; rank < exCount; ++rank) {
+               if (weights[porder[rank]] > 0)
+                  sorted.push_back(porder[rank]);
+            }
+         }
+         const size_t inBag = sorted.size() / std::max<size_t>(m_inputCount, 1);
+
+         struct Pending
+         {
+            size_t begin, end; // range in every input's list
+            uint32_t node;
+         };
+         Tree tree;
+         auto AddNodes = [&tree](size_t count) {
+            tree.features.resize(tree.features.size() + count, LEAF);
+            tree.thresholds.resize(tree.features.size(), (TData)0.0);
+            tree.children.resize(tree.features.size(), 0);
+         };
+         AddNodes(1);
+         std::vector<Pending> level = { { 0, inBag, 0 } }, next;
+
+         std::vector<uint32_t> inputIds(m_inputCount), buffer(inBag);
+         std::iota(inputIds.begin(), inputIds.end(), 0);
+         std::vector<TData> sum(outN), left(outN);
+         std::vector<uint8_t> goesLeft(exCount);
 
+         for (size_t depth = 0; !level.empty(); ++depth) {
+            next.clear();
+            for (const Pending& p : level) {
+               const uint32_t *pnode = sorted.data() + p.begin; // the node's examples as listed for input 0
+               TData weight = 0;
+               std::fill(sum.begin(), sum.end(), (TData)0.0);
+               for (size_t r = 0; r < p.end - p.begin; ++r) {
+                  const TData w = weights[pnode[r]];
+                  const TData *py = &columns.outputs[pnode[r] * outN];
+                  weight += w;
+                  for (size_t i = 0; i < outN; ++i)
+                     sum[i] += w * py[i];
+               }
+
+               // best split over mtry random inputs, by the decrease of the summed squared error
+               uint32_t bestInput = LEAF;
+               TData bestThreshold = 0, bestGain = 0;
+               if (depth < params.maxDepth && weight >= 2 * minLeaf) {
+                  const TData parentScore = Dot(sum.data(), sum.data(), outN) / weight;
+                  for (size_t k = 0; k < mtry; ++k) {
+                     std::swap(inputIds[k], inputIds[k + engine() % (m_inputCount - k)]);
+                     const uint32_t input = inputIds[k];
+                     const uint32_t *plist = sorted.data() + input * inBag + p.begin;
+                     const TData *pvalues = &columns.values[input * exCount];
+
+                     TData leftWeight = 0;
+                     std::fill(left.begin(), left.end(), (TData)0.0);
+                     for (size_t r = 0; r + 1 < p.end - p.begin; ++r) {
+                        const TData w = weights[plist[r]];
+                        const TData *py = &columns.outputs[plist[r] * outN];
+                        leftWeight += w;
+                        for (size_t i = 0; i < outN; ++i)
+                           left[i] += w * py[i];
+
+                        const TData x = pvalues[plist[r]], xnext = pvalues[plist[r + 1]];
+                        const TData rightWeight = weight - leftWeight;
+                        if (!(x < xnext) || leftWeight < minLeaf || rightWeight < minLeaf)
+                           continue;
+                        TData leftScore = Dot(left.data(), left.data(), outN), rightScore = 0;
+                        for (size_t i = 0; i < outN; ++i)
+                           rightScore += (sum[i] - left[i]) * (sum[i] - left[i]);
+                        const TData gain = leftScore / leftWeight + rightScore / rightWeight - parentScore;
+                        if (gain > bestGain) {
+                           bestGain = gain;
+                           bestInput = input;
+                           const TData mid = x + (xnext - x) / 2;
+                           bestThreshold = mid < xnext ? mid : x;
+                        }
+                     }
+                  }
+               }
+
+               if (bestInput == LEAF || !(bestGain > (TData)1e-12 * weight)) {
+                  tree.children[p.node] = (uint32_t)tree.leafValues.size();
+                  for (size_t i = 0; i < outN; ++i)
+                     tree.leafValues.push_back(sum[i] / weight);
+                  continue;
+               }
+
+               // stable partition of every input's list, so the children's lists stay sorted
+               const TData *pvalues = &columns.values[bestInput * exCount];
+               for (size_t r = p.begin; r < p.end; ++r) {
+                  const uint32_t ex = sorted[bestInput * inBag + r];
+                  goesLeft[ex] = !(pvalues[ex] > bestThreshold);
+               }
+               size_t mid = p.begin;
+               for (size_t input = 0; input < m_inputCount; ++input) {
+                  uint32_t *plist = sorted.data() + input * inBag;
+                  size_t l = p.begin, b = 0;
+                  for (size_t r = p.begin; r < p.end; ++r) {
+                     if (goesLeft[plist[r]])
+                        plist[l++] = plist[r];
+                     else
+                        buffer[b++] = plist[r];
+                  }
+                  std::copy(buffer.cbegin(), buffer.cbegin() + b, plist + l);
+                  mid = l;
+               }
+
+               const uint32_t leftChild = (uint32_t)tree.features.size();
+               AddNodes(2);
+               tree.features[p.node] = bestInput;
+               tree.thresholds[p.node] = bestThreshold;
+               tree.children[p.node] = leftChild;
+               next.push_back({ p.begin, mid, leftChild });
+               next.push_back({ mid, p.end, leftChild + 1 });
+            }
+            level.swap(next);
+         }
+         return tree;
+      }
+      static TData Dot(const TData *a, const TData *b, size_t n)
+      {
+         TData res = 0;
+         for (size_t i = 0; i < n; ++i)
+            res += a[i] * b[i];
+         return res;
+      }
+   };
 }
-#endif
\ No newline at end of file
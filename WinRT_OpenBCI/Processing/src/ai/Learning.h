@@ -27,6 +27,16 @@
 #include <random>
 #include <cassert>
 #include <mutex>
+#include <atomic>
+#include <cstdint>
+#include <fstream>
+#include <chrono>
+#include "LinearAlgebra.h"
+#include "ModelFile.h"
+#include "Optimizers.h"
+#include "Dataset.h"
+#include "DecisionTree.h"
+#include "LinearModels.h"
 
 using namespace Platform;
 using namespace Platform::Collections;
@@ -102,7 +112,7 @@ namespace Processing
       }
       TData GetOutput(const TData *pinputs) const
       {
-         TData sum = std::inner_product(m_pweights, m_pweights + m_size - 1, pinputs, m_biasWeight);
+         TData sum = Gemm<TData>::Dot(m_pweights, pinputs, m_size - 1) + m_biasWeight;
          return m_Func(sum);
       }
    };
@@ -132,10 +142,23 @@ namespace Processing
       virtual size_t GetNodeCount() const noexcept = 0;
       virtual size_t GetInputCount() const noexcept = 0;
       virtual size_t GetOutputCount() const noexcept = 0;
+      // safe to call concurrently on the same network
       virtual void ComputeOutputs(const TData *pinputs, OUT TData *poutputs) const = 0;
-      virtual std::unique_ptr<ITrainer<TData>> CreateTrainer() = 0;
+      // count examples, row-major [example][input] in and [example][output] out
+      virtual void ComputeBatch(const TData *pinputs, size_t count, OUT TData *poutputs) const
+      {
+         for (size_t ex = 0; ex < count; ++ex)
+            ComputeOutputs(pinputs + ex * GetInputCount(), poutputs + ex * GetOutputCount());
+      }
+      virtual std::unique_ptr<ITrainer<TData>> CreateTrainer(OptimizerType optimizer = OptimizerType::GradientDescent) = 0;
+      // deep copy, e.g. to be trained while the original keeps serving
+      virtual std::unique_ptr<INetwork<TData>> Clone() const = 0;
    };
 
+   // Thrown by ITrainer::Update() of models that can only be fitted to all examples at once
+   class UpdateNotSupportedException : public std::exception
+   { };
+
    template <typename TData>
    class ITrainer
    {
@@ -143,7 +166,33 @@ namespace Processing
 
    public:
       virtual ~ITrainer() { }
-      virtual void Train(const std::vector<std::vector<TData>>& trainingSet, const std::vector<std::vector<TData>>& outputs) = 0;
+      // rows of GetInputCount() and GetOutputCount() values, each example is read in place
+      virtual void Train(const std::vector<const TData *>& inputs, const std::vector<const TData *>& outputs) = 0;
+      void Train(const Dataset<TData>& examples)
+      {
+         std::vector<const TData *> inputs, outputs;
+         examples.GetRows(&inputs, &outputs);
+         Train(inputs, outputs);
+      }
+      void Train(const std::vector<std::vector<TData>>& trainingSet, const std::vector<std::vector<TData>>& outputs)
+      {
+         assert(trainingSet.size() == outputs.size());
+         std::vector<const TData *> ins, outs;
+         for (size_t i = 0; i < trainingSet.size(); ++i) {
+            ins.push_back(trainingSet[i].data());
+            outs.push_back(outputs[i].data());
+         }
+         Train(ins, outs);
+      }
+      // learning rate as a function of the epoch, DefaultLearningRate unless set
+      virtual void SetLearningRate(std::function<TData(int)> RateFactory) = 0;
+      // Train() stops after maxEpochs epochs if early stopping hasn't stopped it before, 0 for no limit (default)
+      virtual void SetMaxEpochs(size_t maxEpochs) = 0;
+      // One update on the given examples at a fixed rate, without validation or early stopping.
+      // Optimizer state is kept between calls, so repeated updates continue where the last one stopped.
+      // Throws UpdateNotSupportedException for models without incremental updates.
+      virtual void Update(const std::vector<const TData *>& inputs, const std::vector<const TData *>& outputs,
+                          TData rate) = 0;
    };
 
 #pragma endregion
@@ -163,56 +212,51 @@ namespace Processing
       typedef TData val_t;
       typedef BPNetwork<TData> My_t;
       typedef INetwork<TData> Base_t;
-      typedef SigmoidUnit<TData> Node_t;
-      typedef unsigned char byte;
 
    private:
-      std::unique_ptr<byte[]> m_pmemblock;
-      byte * const m_pnodes;
-      byte * const m_pweights;
-      byte * const m_pouts;
       const size_t IN_N, OUT_N, N, L;
 
-      BPNetwork(size_t nodeCount, size_t weightsCount, size_t inN, size_t N, size_t outN, size_t L)
-         : m_pmemblock(std::make_unique<byte[]>((sizeof(Node_t) + sizeof(TData)) * nodeCount + sizeof(TData) * weightsCount)),
-         m_pnodes(m_pmemblock.get()),
-         m_pweights(m_pnodes + sizeof(Node_t) * nodeCount),
-         m_pouts(m_pweights + sizeof(TData) * weightsCount),
-         IN_N(inN), OUT_N(outN), N(N), L(L)
-      { }
+      // all layers in one block, each weight matrix and bias vector on a MODEL_ALIGNMENT boundary
+      // (relative to the block), which is also the payload layout of a model file
+      std::vector<TData> m_storage;       // empty when the weights live in a mapped file
+      std::shared_ptr<void> m_pmapping;   // keeps the mapped file alive
+      std::vector<TData *> m_weights;     // [layer] -> row-major [node][fan-in]
+      std::vector<TData *> m_biases;      // [layer] -> [node]
+
+      // a copy always owns its weights, so that a clone of a mapped network can be trained
+      BPNetwork(const My_t& other) : IN_N(other.IN_N), OUT_N(other.OUT_N), N(other.N), L(other.L),
+         m_storage(other.m_weights[0], other.m_weights[0] + other.GetStorageLength())
+      {
+         Bind(m_storage.data());
+      }
+      // weights used in place, pstorage must stay valid as long as pmapping is held
+      BPNetwork(size_t inN, size_t N, size_t outN, size_t L, TData *pstorage, std::shared_ptr<void> pmapping)
+         : IN_N(inN), OUT_N(outN), N(N), L(L), m_pmapping(std::move(pmapping))
+      {
+         Bind(pstorage);
+      }
 
    public:
       // inN doesn't include bias unit
       // InitWeightFactory takes fan-in (size_t) and returns one initial weight (TData)
       template <typename F>
       BPNetwork(size_t inN, size_t N, size_t outN, size_t L, F InitWeightFactory)
-         : BPNetwork((L - 1) * N + outN,
-                            N*inN + ((L - 2) * N + outN) * N,
-                            inN, N, outN, L)
+         : IN_N(inN), OUT_N(outN), N(N), L(L), m_storage(GetStorageLength(), (TData)0.0)
       {
-         byte *pn = m_pnodes;
-         byte *pw = m_pweights;
-
+         Bind(m_storage.data());
          for (int layer = 0; layer < L; ++layer) {
-            for (int node = 0; node < GetLayerSize(layer); ++node) {
-               // allocate weights array
-               size_t wlen = (layer == 0) ? IN_N : N;
-               TData *pweights = new(pw) TData[wlen];
-               pw += sizeof(TData) * wlen;
-
-               // allocate node
-               Node_t *pnode = new(pn) Node_t(pweights, wlen);
-               pn += sizeof(Node_t);
+            const size_t size = GetLayerSize(layer), wlen = GetFanIn(layer);
 
+            for (int node = 0; node < size; ++node) {
                // fill initial weights
+               TData *pweights = &m_weights[layer][node * wlen];
                for (int i = 0; i < wlen; ++i) 
                   pweights[i] = InitWeightFactory(wlen + 1);
                TData norm = std::sqrt(std::inner_product(pweights, pweights+wlen, pweights, 0.0));
-               pnode->SetWeightAt(0, 0.75 * norm); // Russel & Marks, Neural Smithing, p.103
+               m_biases[layer][node] = 0.75 * norm; // Russel & Marks, Neural Smithing, p.103
             }
          }
       }
-      BPNetwork(const My_t&) = delete;
       My_t& operator =(const My_t&) = delete;
 
       virtual size_t GetNodeCount() const noexcept
@@ -227,42 +271,53 @@ namespace Processing
       {
          return OUT_N;
       }
+      // one GEMV with fused bias and sigmoid per layer, threaded only for large layers
       virtual void ComputeOutputs(const TData *pinputs, OUT TData *poutputs) const
       {
          assert(pinputs != nullptr);
 
-         const Node_t *pn = reinterpret_cast<Node_t *>(m_pnodes);
-         TData *pres = reinterpret_cast<TData *>(m_pouts);
-
-         // layer 0
-         concurrency::parallel_for((size_t)0, N, [pres, pn, pinputs](size_t node) {
-            pres[node] = (pn + node)->GetOutput(pinputs);
-         }, concurrency::static_partitioner());
-         pn += N;
-         pres += N;
-
-         // layer 1 through L-2 inclusively
-         for (int layer = 1; layer < L - 1; ++layer) {
-            TData *pinput = pres - N;
-            concurrency::parallel_for((size_t)0, N, [pres, pn, pinput](size_t node) {
-               pres[node] = (pn + node)->GetOutput(pinput);
-            }, concurrency::static_partitioner());
-            pn += N;
-            pres += N;
+         // layer outputs alternate between the two halves, per thread so that concurrent callers don't interfere
+         thread_local std::vector<TData> scratch;
+         const size_t width = std::max(N, OUT_N);
+         scratch.resize(2 * width);
+
+         const TData *pin = pinputs;
+         for (size_t layer = 0; layer < L; ++layer) {
+            const size_t fanIn = GetFanIn(layer);
+            TData *pres = scratch.data() + (layer % 2) * width;
+            Gemm<TData>::GemvSigmoid(GetLayerSize(layer), fanIn, m_weights[layer], fanIn, pin, m_biases[layer], pres);
+            pin = pres;
          }
 
-         // layer L-1
-         TData *pinput = pres - N;
-         concurrency::parallel_for((size_t)0, OUT_N, [pres, pn, pinput](size_t node) {
-            pres[node] = (pn + node)->GetOutput(pinput);
-         }, concurrency::static_partitioner());
-
          if (poutputs)
-            std::copy(pres, pres + OUT_N, poutputs);
+            std::copy(pin, pin + OUT_N, poutputs);
       }
-      virtual std::unique_ptr<ITrainer<TData>> CreateTrainer()
+      // one matrix product per layer instead of count GEMVs
+      virtual void ComputeBatch(const TData *pinputs, size_t count, OUT TData *poutputs) const
       {
-         return std::make_unique<Trainer<My_t>>(this);
+         assert(pinputs != nullptr && poutputs != nullptr);
+
+         thread_local std::vector<TData> scratch;
+         const size_t width = std::max(N, OUT_N) * count;
+         scratch.resize(2 * width);
+
+         const TData *pin = pinputs;
+         for (size_t layer = 0; layer < L; ++layer) {
+            const size_t size = GetLayerSize(layer), fanIn = GetFanIn(layer);
+            TData *pres = layer == L - 1 ? poutputs : scratch.data() + (layer % 2) * width;
+            Gemm<TData>::NT(count, size, fanIn, (TData)1.0, pin, fanIn, m_weights[layer], fanIn, pres, size, false);
+            for (size_t ex = 0; ex < count; ++ex)
+               AddBiasSigmoid(size, m_biases[layer], pres + ex * size);
+            pin = pres;
+         }
+      }
+      virtual std::unique_ptr<ITrainer<TData>> CreateTrainer(OptimizerType optimizer = OptimizerType::GradientDescent)
+      {
+         return std::make_unique<Trainer<My_t>>(this, optimizer);
+      }
+      virtual std::unique_ptr<INetwork<TData>> Clone() const
+      {
+         return std::unique_ptr<INetwork<TData>>(new My_t(*this));
       }
 
       size_t GetLayerCount() const noexcept
@@ -273,21 +328,103 @@ namespace Processing
       {
          return layer == L - 1 ? OUT_N : N;
       }
-      Node_t *GetNodeAt(size_t layer, size_t index) const
+      // number of weights per node of the layer, bias excluded
+      size_t GetFanIn(size_t layer) const noexcept
+      {
+         return layer == 0 ? IN_N : N;
+      }
+      // row-major [GetLayerSize(layer)][GetFanIn(layer)]
+      TData *GetLayerWeights(size_t layer)
       {
          assert(layer < L);
-         assert((layer == L - 1 && index < OUT_N) || (layer < L - 1 && index < N));
-
-         Node_t *pn = reinterpret_cast<Node_t *>(m_pnodes);
-         return &pn[layer * N + index];
+         return m_weights[layer];
+      }
+      const TData *GetLayerWeights(size_t layer) const
+      {
+         assert(layer < L);
+         return m_weights[layer];
       }
-      TData GetOutputAt(size_t layer, size_t index) const
+      // [GetLayerSize(layer)]
+      TData *GetLayerBiases(size_t layer)
       {
          assert(layer < L);
-         assert((layer == L - 1 && index < OUT_N) || (layer < L - 1 && index < N));
+         return m_biases[layer];
+      }
+      const TData *GetLayerBiases(size_t layer) const
+      {
+         assert(layer < L);
+         return m_biases[layer];
+      }
+
+      // All weights and biases as one block, laid out as in a model file. Padding between the
+      // layers is zero, so per-parameter arrays of the same length can mirror it.
+      TData *GetParameters() noexcept
+      {
+         return m_weights[0];
+      }
+      size_t GetParameterCount() const noexcept
+      {
+         return GetStorageLength();
+      }
+      // Writes the topology and all weights; the payload is the weight block as is
+      void Save(std::ostream& out, InputNormalization normalization) const
+      {
+         ModelFileHeader header = {};
+         header.magic = ModelFileHeader::MAGIC;
+         header.version = ModelFileHeader::VERSION;
+         header.type = ModelType::BackPropagation;
+         header.scalarSize = sizeof(TData);
+         header.inputCount = (uint32_t)IN_N;
+         header.outputCount = (uint32_t)OUT_N;
+         header.layerSize = (uint32_t)N;
+         header.layerCount = (uint32_t)L;
+         header.normalization = normalization;
+         header.payloadOffset = MODEL_ALIGNMENT;
+         header.payloadSize = GetStorageLength() * sizeof(TData);
+         WriteModel(out, header, m_weights[0]);
+      }
+      // Network whose weights point straight into the mapped payload, nothing is copied
+      static std::unique_ptr<My_t> Load(const std::shared_ptr<MappedFile>& pfile)
+      {
+         const ModelFileHeader& header = pfile->GetModelHeader();
+         if (header.type != ModelType::BackPropagation || header.scalarSize != sizeof(TData) ||
+             header.inputCount == 0 || header.outputCount == 0 || header.layerCount == 0 ||
+             (header.layerCount > 1 && header.layerSize == 0))
+            throw std::invalid_argument("model file doesn't hold a compatible back-propagation network");
+         if (GetStorageLength(header.inputCount, header.layerSize, header.outputCount, header.layerCount) * sizeof(TData) != header.payloadSize)
+            throw std::invalid_argument("truncated model file");
+
+         // the view is copy-on-write, so the weights can be exposed as mutable without touching the file
+         TData *pstorage = reinterpret_cast<TData *>(const_cast<uint8_t *>(pfile->GetPayload()));
+         return std::unique_ptr<My_t>(new My_t(header.inputCount, header.layerSize, header.outputCount, header.layerCount,
+                                               pstorage, pfile));
+      }
 
-         TData *pres = reinterpret_cast<TData *>(m_pouts);
-         return pres[layer * N + index];
+   private:
+      static size_t GetStorageLength(size_t inN, size_t N, size_t outN, size_t L) noexcept
+      {
+         size_t length = 0;
+         for (size_t layer = 0; layer < L; ++layer) {
+            const size_t size = layer == L - 1 ? outN : N, fanIn = layer == 0 ? inN : N;
+            length += AlignedCount<TData>(size * fanIn) + AlignedCount<TData>(size);
+         }
+         return length;
+      }
+      size_t GetStorageLength() const noexcept
+      {
+         return GetStorageLength(IN_N, N, OUT_N, L);
+      }
+      void Bind(TData *pstorage)
+      {
+         m_weights.resize(L);
+         m_biases.resize(L);
+         for (size_t layer = 0; layer < L; ++layer) {
+            const size_t size = GetLayerSize(layer);
+            m_weights[layer] = pstorage;
+            pstorage += AlignedCount<TData>(size * GetFanIn(layer));
+            m_biases[layer] = pstorage;
+            pstorage += AlignedCount<TData>(size);
+         }
       }
    };
 
@@ -309,10 +446,30 @@ namespace Processing
 
       std::vector<TData> m_outWeights;
       std::vector<std::unique_ptr<TData[]>> m_hidWeights;
-      mutable std::vector<TData> m_outputs;  // first hidden nodes, then output layer
+      std::vector<TData> m_outputs;  // first hidden nodes, then output layer, as of the last ComputeStates()
+      std::vector<TData> m_inputs;   // inputs followed by hidden outputs, the output layer's fan-in
 
       std::function<TData(size_t)> m_WeightFactory;
 
+      // nodes are rebound to the copied weights
+      CCNetwork(const My_t& other) : IN_N(other.IN_N), OUT_N(other.OUT_N),
+         m_outWeights(other.m_outWeights), m_WeightFactory(other.m_WeightFactory)
+      {
+         for (size_t i = 0; i < other.m_hidNodes.size(); ++i) {
+            size_t wlen = IN_N + i;
+            auto pweights = std::make_unique<TData[]>(wlen);
+            std::copy(other.m_hidWeights[i].get(), other.m_hidWeights[i].get() + wlen, pweights.get());
+            m_hidNodes.emplace_back(pweights.get(), wlen);
+            m_hidNodes.back().SetWeightAt(0, other.m_hidNodes[i].GetWeightAt(0));
+            m_hidWeights.emplace_back(std::move(pweights));
+         }
+         size_t wlen = IN_N + m_hidNodes.size();
+         for (size_t i = 0; i < OUT_N; ++i) {
+            m_outNodes.emplace_back(&m_outWeights[i * wlen], wlen);
+            m_outNodes.back().SetWeightAt(0, other.m_outNodes[i].GetWeightAt(0));
+         }
+      }
+
    public:
       template <typename TFunc>
       CCNetwork(size_t inN, size_t outN, TFunc&& InitWeightFactory) : IN_N(inN), OUT_N(outN),
@@ -329,7 +486,6 @@ namespace Processing
             SetBiasWeight(pnode, pweights, IN_N);
          }
       }
-      CCNetwork(const My_t&) = delete;
       My_t& operator =(const My_t&) = delete;
 
       virtual size_t GetNodeCount() const noexcept
@@ -346,42 +502,55 @@ namespace Processing
       }
       virtual void ComputeOutputs(const TData *pinputs, OUT TData *poutputs) const
       {
-         assert(pinputs != nullptr);
-
-         m_outputs.clear();
-         std::vector<TData> inputs(pinputs, pinputs + IN_N);
-
-         for (const Node_t& node : m_hidNodes) {
-            TData out = node.GetOutput(inputs.data());
-            inputs.push_back(out);
-            m_outputs.push_back(out);
-         }
-         for (const Node_t& node : m_outNodes) {
-            TData out = node.GetOutput(inputs.data());
-            m_outputs.push_back(out);
-         }
+         thread_local std::vector<TData> inputs, outputs;
+         Propagate(pinputs, &inputs, &outputs);
+         if (poutputs)
+            std::copy(outputs.cbegin() + m_hidNodes.size(), outputs.cend(), poutputs);
+      }
+      virtual std::unique_ptr<ITrainer<TData>> CreateTrainer(OptimizerType optimizer = OptimizerType::GradientDescent)
+      {
+         return std::make_unique<Trainer<My_t>>(this, optimizer);
+      }
+      virtual std::unique_ptr<INetwork<TData>> Clone() const
+      {
+         return std::unique_ptr<INetwork<TData>>(new My_t(*this));
+      }
 
+      // Same as ComputeOutputs, but keeps the hidden outputs for GetHiddenOutput(); not thread-safe
+      void ComputeStates(const TData *pinputs, OUT TData *poutputs)
+      {
+         Propagate(pinputs, &m_inputs, &m_outputs);
          if (poutputs)
             std::copy(m_outputs.cbegin() + m_hidNodes.size(), m_outputs.cend(), poutputs);
       }
-      virtual std::unique_ptr<ITrainer<TData>> CreateTrainer()
+      // Initial weights for the next hidden unit, [0] is the bias weight followed by GetInputCount() + GetHiddenCount() weights
+      std::vector<TData> DrawHiddenWeights()
       {
-         return std::make_unique<Trainer<My_t>>(this);
+         size_t wlen = IN_N + m_hidNodes.size();
+         std::vector<TData> weights(wlen + 1);
+         for (size_t i = 1; i <= wlen; ++i)
+            weights[i] = m_WeightFactory(wlen + 1);
+         TData norm = std::sqrt(std::inner_product(weights.cbegin() + 1, weights.cend(), weights.cbegin() + 1, 0.0));
+         weights[0] = 0.75 * norm;
+         return weights;
       }
-
-      // Adds a new hidden unit and regenerates the output layer
+      // Adds a new hidden unit with random weights and regenerates the output layer
       Node_t *AddHiddenNode()
+      {
+         return AddHiddenNode(DrawHiddenWeights().data());
+      }
+      // Adds a new hidden unit with the given weights, laid out as by DrawHiddenWeights(), and regenerates the output layer
+      Node_t *AddHiddenNode(const TData *pweightsWithBias)
       {
          // allocate and assign hidden weights
          size_t wlen = IN_N + m_hidNodes.size();
          auto pweights = std::make_unique<TData[]>(wlen);
-         for (int i = 0; i < wlen; ++i)
-            pweights[i] = m_WeightFactory(wlen + 1);
+         std::copy(pweightsWithBias + 1, pweightsWithBias + 1 + wlen, pweights.get());
 
          // add hidden node and set bias weight
          m_hidNodes.emplace_back(pweights.get(), wlen);
          m_hidWeights.emplace_back(std::move(pweights));
-         SetBiasWeight(&m_hidNodes.back(), m_hidWeights.back().get(), wlen);
+         m_hidNodes.back().SetWeightAt(0, pweightsWithBias[0]);
 
          // regenerate output nodes retaining previous weights
          m_outNodes.clear();
@@ -413,13 +582,118 @@ namespace Processing
          assert(hidIndex < m_hidNodes.size());
          return &m_hidNodes[hidIndex];
       }
+      const Node_t *GetOutputNode(size_t outIndex) const
+      {
+         assert(outIndex < m_outNodes.size());
+         return &m_outNodes[outIndex];
+      }
+      const Node_t *GetHiddenNode(size_t hidIndex) const
+      {
+         assert(hidIndex < m_hidNodes.size());
+         return &m_hidNodes[hidIndex];
+      }
+      size_t GetHiddenCount() const noexcept
+      {
+         return m_hidNodes.size();
+      }
       TData GetHiddenOutput(size_t hidIndex) const
       {
          assert(hidIndex < m_hidNodes.size());
          return m_outputs[hidIndex];
       }
+      // Writes the topology and all weights: each hidden unit as [bias, weights], then the output
+      // biases and the row-major [output][fan-in] output weights
+      void Save(std::ostream& out, InputNormalization normalization) const
+      {
+         const size_t H = m_hidNodes.size();
+         std::vector<TData> payload(GetPayloadLength(IN_N, OUT_N, H), (TData)0.0);
+         TData *pdest = payload.data();
+         for (size_t i = 0; i < H; ++i) {
+            const size_t wlen = IN_N + i;
+            pdest[0] = m_hidNodes[i].GetWeightAt(0);
+            std::copy(m_hidWeights[i].get(), m_hidWeights[i].get() + wlen, pdest + 1);
+            pdest += AlignedCount<TData>(wlen + 1);
+         }
+         for (size_t i = 0; i < OUT_N; ++i)
+            pdest[i] = m_outNodes[i].GetWeightAt(0);
+         pdest += AlignedCount<TData>(OUT_N);
+         std::copy(m_outWeights.cbegin(), m_outWeights.cend(), pdest);
+
+         ModelFileHeader header = {};
+         header.magic = ModelFileHeader::MAGIC;
+         header.version = ModelFileHeader::VERSION;
+         header.type = ModelType::CascadeCorrelation;
+         header.scalarSize = sizeof(TData);
+         header.inputCount = (uint32_t)IN_N;
+         header.outputCount = (uint32_t)OUT_N;
+         header.layerSize = (uint32_t)H;
+         header.normalization = normalization;
+         header.payloadOffset = MODEL_ALIGNMENT;
+         header.payloadSize = payload.size() * sizeof(TData);
+         WriteModel(out, header, payload.data());
+      }
+      // Units keep their bias apart from the weights, so unlike BPNetwork the weights are copied out of the file.
+      // InitWeightFactory is only used for hidden units added by further training.
+      template <typename TFunc>
+      static std::unique_ptr<My_t> Load(const MappedFile& file, TFunc&& InitWeightFactory)
+      {
+         const ModelFileHeader& header = file.GetModelHeader();
+         if (header.type != ModelType::CascadeCorrelation || header.scalarSize != sizeof(TData) ||
+             header.inputCount == 0 || header.outputCount == 0)
+            throw std::invalid_argument("model file doesn't hold a compatible cascade-correlation network");
+         const size_t IN_N = header.inputCount, OUT_N = header.outputCount, H = header.layerSize;
+         if (GetPayloadLength(IN_N, OUT_N, H) * sizeof(TData) != header.payloadSize)
+            throw std::invalid_argument("truncated model file");
+
+         auto pnet = std::make_unique<My_t>(IN_N, OUT_N, std::forward<TFunc>(InitWeightFactory));
+         const TData *psrc = reinterpret_cast<const TData *>(file.GetPayload());
+         for (size_t i = 0; i < H; ++i) {
+            const size_t wlen = IN_N + i;
+            auto pweights = std::make_unique<TData[]>(wlen);
+            std::copy(psrc + 1, psrc + 1 + wlen, pweights.get());
+            pnet->m_hidNodes.emplace_back(pweights.get(), wlen);
+            pnet->m_hidNodes.back().SetWeightAt(0, psrc[0]);
+            pnet->m_hidWeights.emplace_back(std::move(pweights));
+            psrc += AlignedCount<TData>(wlen + 1);
+         }
+         pnet->GenerateOutputNodes(IN_N + H);
+         const TData *pbiases = psrc;
+         psrc += AlignedCount<TData>(OUT_N);
+         std::copy(psrc, psrc + pnet->m_outWeights.size(), pnet->m_outWeights.begin());
+         for (size_t i = 0; i < OUT_N; ++i)
+            pnet->m_outNodes[i].SetWeightAt(0, pbiases[i]);
+         return pnet;
+      }
       
    private:
+      static size_t GetPayloadLength(size_t inN, size_t outN, size_t H) noexcept
+      {
+         size_t length = AlignedCount<TData>(outN) + AlignedCount<TData>(outN * (inN + H));
+         for (size_t i = 0; i < H; ++i)
+            length += AlignedCount<TData>(inN + i + 1);
+         return length;
+      }
+      void Propagate(const TData *pinputs, std::vector<TData> *pin, std::vector<TData> *pout) const
+      {
+         assert(pinputs != nullptr);
+
+         std::vector<TData>& inputs = *pin;
+         std::vector<TData>& outputs = *pout;
+         const size_t H = m_hidNodes.size();
+         inputs.resize(IN_N + H);
+         outputs.resize(H + OUT_N);
+         std::copy(pinputs, pinputs + IN_N, inputs.begin());
+
+         // each hidden node sees all inputs and the hidden nodes before it
+         for (size_t i = 0; i < H; ++i) {
+            TData out = m_hidNodes[i].GetOutput(inputs.data());
+            inputs[IN_N + i] = out;
+            outputs[i] = out;
+         }
+         for (size_t i = 0; i < OUT_N; ++i) {
+            outputs[H + i] = m_outNodes[i].GetOutput(inputs.data());
+         }
+      }
       // does not assign initial weights
       void GenerateOutputNodes(size_t wlen)
       {
@@ -449,6 +723,35 @@ namespace Processing
       return u(rd);
    }
 
+   // Same distribution as BottouWeightFactory, but reproducible. A copy, e.g. in a cloned network, gets an engine
+   // of its own seeded from the state of the original, so that copies can draw concurrently.
+   template <typename TData>
+   class SeededWeightFactory
+   {
+      REQUIRES_FLOAT(TData);
+
+      mutable std::mt19937 m_engine;
+
+   public:
+      explicit SeededWeightFactory(std::mt19937::result_type seed) : m_engine(seed)
+      { }
+      SeededWeightFactory(const SeededWeightFactory& other) : m_engine(std::mt19937(other.m_engine)())
+      { }
+      SeededWeightFactory(SeededWeightFactory&&) = default;
+      SeededWeightFactory& operator=(const SeededWeightFactory& other)
+      {
+         m_engine.seed(std::mt19937(other.m_engine)());
+         return *this;
+      }
+      SeededWeightFactory& operator=(SeededWeightFactory&&) = default;
+      TData operator()(size_t fanIn) const
+      {
+         TData bound = (TData)2.38 / std::sqrt((TData)fanIn);
+         std::uniform_real_distribution<TData> u(-bound, bound);
+         return u(m_engine);
+      }
+   };
+
    template <typename TData>
    inline TData DefaultLearningRate(int t)
    {
@@ -469,60 +772,80 @@ namespace Processing
 
       std::function<val_t(int)> m_RateFactory;
       TNetwork<val_t> *m_pnet;
+      size_t m_maxEpochs;
+
+   private:
+      std::vector<val_t> m_valInputs;  // [example][input]
+      std::vector<val_t> m_valResults; // [example][output]
+
+   protected:
 
       template <typename TFunc>
       TrainerBase(TNetwork<val_t> *network, TFunc&& LearningRateFactory)
-         : m_RateFactory(std::forward<TFunc>(LearningRateFactory)), m_pnet(network)
+         : m_RateFactory(std::forward<TFunc>(LearningRateFactory)), m_pnet(network), m_maxEpochs(0)
       { }
-      // avg error over all validation examples
-      TData GetAvgError(val_t *pvalres,
-                        const std::vector<const std::vector<val_t> *>& valSet, 
-                        const std::vector<const std::vector<val_t> *>& valOuts)
+      // avg error over all validation examples, evaluated as one batch
+      TData GetAvgError(const std::vector<const val_t *>& valSet, 
+                        const std::vector<const val_t *>& valOuts)
       {
-         std::vector<val_t> absErrors(m_pnet->GetOutputCount(), 0.0);
-         for (int ex = 0; ex < valSet.size(); ++ex) {
-            const std::vector<val_t>& in = *(valSet[ex]);
-            const std::vector<val_t>& out = *(valOuts[ex]);
-
-            m_pnet->ComputeOutputs(in.data(), pvalres);
-
-            for (size_t i = 0; i < m_pnet->GetOutputCount(); ++i) {
-               absErrors[i] += std::abs(pvalres[i] - out[i]);
+         const size_t inN = m_pnet->GetInputCount(), outN = m_pnet->GetOutputCount();
+         m_valInputs.resize(valSet.size() * inN);
+         m_valResults.resize(valSet.size() * outN);
+         for (size_t ex = 0; ex < valSet.size(); ++ex)
+            std::copy(valSet[ex], valSet[ex] + inN, m_valInputs.begin() + ex * inN);
+
+         m_pnet->ComputeBatch(m_valInputs.data(), valSet.size(), m_valResults.data());
+
+         std::vector<val_t> absErrors(outN, 0.0);
+         for (size_t ex = 0; ex < valSet.size(); ++ex) {
+            const val_t *out = valOuts[ex];
+            for (size_t i = 0; i < outN; ++i) {
+               absErrors[i] += std::abs(m_valResults[ex * outN + i] - out[i]);
             }
          }
          return std::accumulate(absErrors.cbegin(), absErrors.cend(), 0.0) / absErrors.size(); // avg error over all outputs
       }
 
    public:
-      virtual void Train(const std::vector<std::vector<val_t>>& trainingSet, const std::vector<std::vector<val_t>>& outputs)
+      using ITrainer<TData>::Train;
+
+      virtual void SetLearningRate(std::function<val_t(int)> RateFactory)
+      {
+         m_RateFactory = std::move(RateFactory);
+      }
+      virtual void SetMaxEpochs(size_t maxEpochs)
+      {
+         m_maxEpochs = maxEpochs;
+      }
+      virtual void Train(const std::vector<const val_t *>& trainingSet, const std::vector<const val_t *>& outputs)
       {
          assert(trainingSet.size() == outputs.size());
 
          // Dividing examples into trainings set and validation set 2:1
-         std::vector<const std::vector<val_t> *> trainset;
-         std::vector<const std::vector<val_t> *> trainout;
-         std::vector<const std::vector<val_t> *> valset;
-         std::vector<const std::vector<val_t> *> valout;
+         std::vector<const val_t *> trainset;
+         std::vector<const val_t *> trainout;
+         std::vector<const val_t *> valset;
+         std::vector<const val_t *> valout;
 
          size_t exCount = trainingSet.size();
 
          for (size_t i = 0; i < exCount; ++i) {
             if (i % 3 == 0) {
                // every 3rd example goes to validation set
-               valset.push_back(&trainingSet[i]);
-               valout.push_back(&outputs[i]);
+               valset.push_back(trainingSet[i]);
+               valout.push_back(outputs[i]);
             }
             else {
-               trainset.push_back(&trainingSet[i]);
-               trainout.push_back(&outputs[i]);
+               trainset.push_back(trainingSet[i]);
+               trainout.push_back(outputs[i]);
             }
          }
          InternalTrain(trainset, trainout, valset, valout);
       }
    protected:
       virtual void InternalTrain(
-         const std::vector<const std::vector<val_t> *>& trainSet, const std::vector<const std::vector<val_t> *>& trainOuts,
-         const std::vector<const std::vector<val_t> *>& valSet, const std::vector<const std::vector<val_t> *>& valOuts) = 0;
+         const std::vector<const val_t *>& trainSet, const std::vector<const val_t *>& trainOuts,
+         const std::vector<const val_t *>& valSet, const std::vector<const val_t *>& valOuts) = 0;
 
    };
 
@@ -534,77 +857,135 @@ namespace Processing
       typedef typename Base_t::val_t val_t;
 
    private:
-      std::unique_ptr<val_t[]> m_pdeltas;
+      const size_t m_batchSize;
+      std::vector<val_t> m_inputs;             // [example][input]
+      std::vector<std::vector<val_t>> m_acts;   // [layer] -> [example][node]
+      std::vector<std::vector<val_t>> m_deltas; // [layer] -> [example][node]
+      std::vector<val_t> m_grads;               // dE/dw, laid out as BPNetwork::GetParameters()
+      std::unique_ptr<IOptimizer<val_t>> m_poptimizer;
 
    public:
-      explicit Trainer(BPNetwork<TData> *pnetwork) : Base_t(pnetwork, &DefaultLearningRate<val_t>),
-         m_pdeltas(std::make_unique<val_t[]>(m_pnet->GetNodeCount()))
-      { }
+      // batchSize of 1 gives per-example SGD; full-batch optimizers step once per epoch regardless
+      explicit Trainer(BPNetwork<TData> *pnetwork, OptimizerType optimizer = OptimizerType::GradientDescent, size_t batchSize = 16)
+         : Base_t(pnetwork, &DefaultLearningRate<val_t>),
+         m_batchSize(std::max<size_t>(batchSize, 1)), m_inputs(m_batchSize * pnetwork->GetInputCount()),
+         m_acts(pnetwork->GetLayerCount()), m_deltas(pnetwork->GetLayerCount()),
+         m_grads(pnetwork->GetParameterCount(), (val_t)0.0), m_poptimizer(CreateOptimizer<val_t>(optimizer, pnetwork->GetParameterCount()))
+      {
+         for (size_t layer = 0; layer < m_pnet->GetLayerCount(); ++layer) {
+            m_acts[layer].resize(m_batchSize * m_pnet->GetLayerSize(layer));
+            m_deltas[layer].resize(m_batchSize * m_pnet->GetLayerSize(layer));
+         }
+      }
+      // a single optimizer step on the gradient of all given examples
+      virtual void Update(const std::vector<const val_t *>& inputs, const std::vector<const val_t *>& outputs,
+                          val_t rate)
+      {
+         assert(inputs.size() == outputs.size());
+         for (size_t first = 0; first < inputs.size(); first += m_batchSize)
+            AccumulateRange(inputs, outputs, first, std::min(m_batchSize, inputs.size() - first));
+         UpdateWeights(inputs.size(), rate);
+      }
 
    protected:
-      val_t& Delta(size_t layer, size_t node)
+      const val_t *LayerInputs(size_t layer) const
+      {
+         return layer == 0 ? m_inputs.data() : m_acts[layer - 1].data();
+      }
+      // activations of all layers for the first count examples in m_inputs
+      void ForwardBatch(size_t count)
+      {
+         for (size_t layer = 0; layer < m_pnet->GetLayerCount(); ++layer) {
+            const size_t size = m_pnet->GetLayerSize(layer), fanIn = m_pnet->GetFanIn(layer);
+            val_t *pacts = m_acts[layer].data();
+            Gemm<val_t>::NT(count, size, fanIn, (val_t)1.0, LayerInputs(layer), fanIn, m_pnet->GetLayerWeights(layer), fanIn,
+                            pacts, size, false);
+            for (size_t ex = 0; ex < count; ++ex)
+               AddBiasSigmoid(size, m_pnet->GetLayerBiases(layer), pacts + ex * size);
+         }
+      }
+      // deltas for the examples starting at first in outs
+      void BackwardBatch(const std::vector<const val_t *>& outs, size_t first, size_t count)
+      {
+         // output layer
+         size_t layer = m_pnet->GetLayerCount() - 1;
+         const size_t outN = m_pnet->GetOutputCount();
+         for (size_t ex = 0; ex < count; ++ex) {
+            const val_t *out = outs[first + ex];
+            for (size_t node = 0; node < outN; ++node) {
+               val_t a = m_acts[layer][ex * outN + node];
+               m_deltas[layer][ex * outN + node] = -(out[node] - a) * a * (1 - a);
+            }
+         }
+
+         // other layers, deltas of the layer above through its weights
+         for (; layer-- > 0;) {
+            const size_t size = m_pnet->GetLayerSize(layer), upper = m_pnet->GetLayerSize(layer + 1);
+            val_t *pdeltas = m_deltas[layer].data();
+            Gemm<val_t>::NN(count, size, upper, (val_t)1.0, m_deltas[layer + 1].data(), upper, m_pnet->GetLayerWeights(layer + 1), size,
+                            pdeltas, size, false);
+            const val_t *pacts = m_acts[layer].data();
+            for (size_t i = 0; i < count * size; ++i)
+               pdeltas[i] *= pacts[i] * (1 - pacts[i]);
+         }
+      }
+      // adds the gradients of the batch to m_grads, at the offsets of the corresponding parameters
+      void AccumulateGradients(size_t count)
+      {
+         const val_t *pparams = m_pnet->GetParameters();
+         for (size_t layer = 0; layer < m_pnet->GetLayerCount(); ++layer) {
+            const size_t size = m_pnet->GetLayerSize(layer), fanIn = m_pnet->GetFanIn(layer);
+            const val_t *pdeltas = m_deltas[layer].data();
+            Gemm<val_t>::TN(size, fanIn, count, (val_t)1.0, pdeltas, size, LayerInputs(layer), fanIn,
+                            &m_grads[m_pnet->GetLayerWeights(layer) - pparams], fanIn, true);
+
+            val_t *pbiasGrads = &m_grads[m_pnet->GetLayerBiases(layer) - pparams];
+            for (size_t ex = 0; ex < count; ++ex)
+               Gemm<val_t>::Axpy(size, (val_t)1.0, pdeltas + ex * size, pbiasGrads);
+         }
+      }
+      // gradients are summed over the examples, so an epoch of gradient descent moves the weights as far as per-example updates would
+      void UpdateWeights(size_t count, val_t alpha)
+      {
+         m_poptimizer->Step(m_pnet->GetParameters(), m_grads.data(), count, alpha);
+         std::fill(m_grads.begin(), m_grads.end(), (val_t)0.0);
+      }
+      // gradients of all examples from first on, in batches of at most m_batchSize
+      void AccumulateRange(const std::vector<const val_t *>& ins, const std::vector<const val_t *>& outs,
+                           size_t first, size_t count)
       {
-         size_t ind = 0;
-         for (int i = 0; i < layer; ++i)
-            ind += m_pnet->GetLayerSize(i);
-         return m_pdeltas[ind + node];
+         const size_t inN = m_pnet->GetInputCount();
+         for (size_t ex = 0; ex < count; ++ex) {
+            const val_t *in = ins[first + ex];
+            std::copy(in, in + inN, m_inputs.begin() + ex * inN);
+         }
+         ForwardBatch(count);
+         BackwardBatch(outs, first, count);
+         AccumulateGradients(count);
       }
       virtual void InternalTrain(
-         const std::vector<const std::vector<val_t> *>& trainSet, const std::vector<const std::vector<val_t> *>& trainOuts,
-         const std::vector<const std::vector<val_t> *>& valSet, const std::vector<const std::vector<val_t> *>& valOuts)
+         const std::vector<const val_t *>& trainSet, const std::vector<const val_t *>& trainOuts,
+         const std::vector<const val_t *>& valSet, const std::vector<const val_t *>& valOuts)
       {
-         auto pvalres = std::make_unique<val_t[]>(m_pnet->GetOutputCount()); // validation results
          val_t optErr;
          bool done = false;
 
-         // back-propagation
-         for (int t = 0; !done; ++t) {
+         // back-propagation over mini-batches
+         for (int t = 0; !done && (m_maxEpochs == 0 || (size_t)t < m_maxEpochs); ++t) {
             val_t alpha = m_RateFactory(t);
 
-            for (int ex = 0; ex < trainSet.size(); ++ex) {
-               const std::vector<val_t>& in = *(trainSet[ex]);
-               const std::vector<val_t>& out = *(trainOuts[ex]);
-
-               m_pnet->ComputeOutputs(in.data(), nullptr);
-
-               // output layer
-               int layer = m_pnet->GetLayerCount() - 1;
-               for (int node = 0; node < m_pnet->GetOutputCount(); ++node) {
-                  val_t a = m_pnet->GetOutputAt(layer, node);
-                  Delta(layer, node) =  -(out[node] - a) * a * (1 - a);
-               }
-
-               // other layers
-               for (--layer; layer >= 0; --layer) {
-                  concurrency::parallel_for((size_t)0, m_pnet->GetLayerSize(layer), [this, layer](size_t node) {
-                     val_t a = m_pnet->GetOutputAt(layer, node);
-
-                     val_t sum = 0.0;
-                     for (int prevnode = 0; prevnode < m_pnet->GetLayerSize(layer + 1); prevnode++) {
-                        sum += Delta(layer + 1, prevnode) * m_pnet->GetNodeAt(layer + 1, prevnode)->GetWeightAt(node + 1);
-                     }
-                     Delta(layer, node) = a * (1 - a) * sum;
-                  }, concurrency::static_partitioner());
-               }
-
-               // update weights
-               for (int layer = 0; layer < m_pnet->GetLayerCount(); ++layer) {
-                  concurrency::parallel_for((size_t)0, m_pnet->GetLayerSize(layer), [this, layer, &in, alpha](size_t node) {
-                     auto pnode = m_pnet->GetNodeAt(layer, node);
-
-                     val_t delta = Delta(layer, node);
-                     for (int i = 0; i < pnode->GetWeightsCount(); ++i) {
-                        val_t a = (i == 0) ? 1.0 : ((layer == 0) ? in[i - 1] : m_pnet->GetOutputAt(layer - 1, i - 1));
-                        val_t w = pnode->GetWeightAt(i) - alpha * a * delta;
-                        pnode->SetWeightAt(i, w);
-                     }
-                  }, concurrency::static_partitioner());
-               }
-            } // foreach ex
+            for (size_t first = 0; first < trainSet.size(); first += m_batchSize) {
+               const size_t count = std::min(m_batchSize, trainSet.size() - first);
+               AccumulateRange(trainSet, trainOuts, first, count);
+               if (!m_poptimizer->IsFullBatch())
+                  UpdateWeights(count, alpha);
+            } // foreach batch
+            if (m_poptimizer->IsFullBatch())
+               UpdateWeights(trainSet.size(), alpha);
 
             if (t % 5 == 0) {
                // validation for each 5th epoch
-               val_t avgErr = GetAvgError(pvalres.get(), valSet, valOuts); 
+               val_t avgErr = GetAvgError(valSet, valOuts);
 
                if (t == 0) {
                   optErr = avgErr;
@@ -628,27 +1009,58 @@ namespace Processing
       typedef typename Base_t::val_t val_t;
 
    private:
+      static constexpr size_t BATCH_SIZE = 16; // for optimizers that step more than once per epoch
+
       const val_t m_errThres;
+      const size_t m_candidateCount;
+      const OptimizerType m_optimizerType;
+      std::unique_ptr<IOptimizer<val_t>> m_poptimizer; // recreated whenever a hidden unit changes the output fan-in
+      std::vector<val_t> m_params;                     // output weights, [output][bias, fan-in]
+      std::vector<val_t> m_grads;                      // dE/dw, laid out as m_params
+
+      // Activations of the frozen network over the validation set, column-wise
+      struct ActivationCache
+      {
+         size_t exCount, fanIn, outputCount;
+         std::vector<val_t> fanInStates; // [input or hidden node][ex]
+         std::vector<val_t> errDevs;     // [output][ex], |error| minus its average
+      };
 
    public:
-      explicit Trainer(CCNetwork<TData> *pnetwork, val_t errThreshold = 0.01) : Base_t(pnetwork, &DefaultLearningRate<val_t>), m_errThres(errThreshold)
+      // candidateCount - number of candidate units trained concurrently for each new hidden unit
+      // optimizer is used for the output weights, candidate units always use gradient ascent
+      explicit Trainer(CCNetwork<TData> *pnetwork, OptimizerType optimizer = OptimizerType::GradientDescent,
+                       val_t errThreshold = 0.01, size_t candidateCount = 8)
+         : Base_t(pnetwork, &DefaultLearningRate<val_t>), m_errThres(errThreshold), m_candidateCount(std::max<size_t>(candidateCount, 1)),
+         m_optimizerType(optimizer)
       { }
+      // one pass of output training, the hidden units stay as they are
+      virtual void Update(const std::vector<const val_t *>& inputs, const std::vector<const val_t *>& outputs,
+                          val_t rate)
+      {
+         assert(inputs.size() == outputs.size());
+         std::vector<val_t> outs(m_pnet->GetOutputCount());
+         TrainOutputs(inputs, outputs, outs.data(), rate);
+      }
 
    protected:
-      void TrainOutputs(const std::vector<const std::vector<val_t> *>& trainSet, 
-                        const std::vector<const std::vector<val_t> *>& trainOuts, 
+      void TrainOutputs(const std::vector<const val_t *>& trainSet, 
+                        const std::vector<const val_t *>& trainOuts, 
                         val_t *pouts, val_t alpha)
       {
+         if (m_optimizerType != OptimizerType::GradientDescent)
+            return OptimizeOutputs(trainSet, trainOuts, pouts, alpha);
+
          size_t inputCount = m_pnet->GetInputCount();
          size_t outputCount = m_pnet->GetOutputCount();
 
          for (int ex = 0; ex < trainSet.size(); ++ex) {
-            const std::vector<val_t>& in = *(trainSet[ex]);
-            const std::vector<val_t>& out = *(trainOuts[ex]);
+            const val_t *in = trainSet[ex];
+            const val_t *out = trainOuts[ex];
 
-            m_pnet->ComputeOutputs(in.data(), pouts);
+            m_pnet->ComputeStates(in, pouts);
 
-            concurrency::parallel_for((size_t)0, outputCount, [this, &in, &out, pouts, alpha, inputCount, outputCount](size_t i) {
+            concurrency::parallel_for((size_t)0, outputCount, [this, in, out, pouts, alpha, inputCount, outputCount](size_t i) {
                auto pnode = m_pnet->GetOutputNode(i);
                val_t a = pouts[i];
                val_t delta = -(out[i] - a) * a * (1 - a);
@@ -672,104 +1084,32 @@ namespace Processing
             }, concurrency::static_partitioner());
          }
       }
-      void AddNode(const std::vector<const std::vector<val_t> *>& valSet, const std::vector<const std::vector<val_t> *>& valOuts)
+      // Fahlman's candidate pool: candidates with different initial weights are trained concurrently against
+      // the frozen network, the one whose output correlates best with the residual errors is installed
+      void AddNode(const std::vector<const val_t *>& valSet, const std::vector<const val_t *>& valOuts)
       {
-         size_t inputCount = m_pnet->GetInputCount();
-         size_t outputCount = m_pnet->GetOutputCount();
-         size_t hiddenNodeCount = m_pnet->GetNodeCount() - outputCount;
-         size_t exCount = valSet.size();
-
-         // --- Compute and save necessary data ---
-         std::vector<std::vector<val_t>> errors;         // [ex][output]
-         std::vector<std::vector<val_t>> states;         // [ex][node]
-         std::vector<val_t> avgErrors(outputCount, 0.0); // [output]
-         std::vector<val_t> avgOutput(outputCount, 0.0); // [output]
-
-         for (size_t ex = 0; ex < exCount; ++ex) {
-            const std::vector<val_t>& in = *(valSet[ex]);
-            const std::vector<val_t>& out = *(valOuts[ex]);
-
-            std::vector<val_t> tempStates(inputCount + hiddenNodeCount + outputCount);
-            std::vector<val_t> tempOut(outputCount);
-            m_pnet->ComputeOutputs(in.data(), tempOut.data());
-
-            // fill node states (inputs + hidden nodes + outputs)
-            std::copy(in.cbegin(), in.cend(), tempStates.begin()); // inputs
-            for (size_t node = 0; node < hiddenNodeCount; ++node)
-               tempStates[inputCount + node] = m_pnet->GetHiddenOutput(node); // hidden states
-            std::copy(tempOut.cbegin(), tempOut.cend(), tempStates.begin() + inputCount + hiddenNodeCount); // outputs
-            states.emplace_back(std::move(tempStates));
-
-            // sum outputs and errors
-            for (size_t output = 0; output < outputCount; ++output) {
-               avgOutput[output] += tempOut[output];
-               tempOut[output] = std::abs(tempOut[output] - out[output]);
-               avgErrors[output] += tempOut[output];
-            }
-            errors.emplace_back(std::move(tempOut));
-         }
-         // calculate average errors and outputs
-         for (size_t output = 0; output < outputCount; ++output) {
-            avgErrors[output] /= exCount;
-            avgOutput[output] /= exCount;
-         }
-
-         // --- Add a new node ---
-         auto pnode = m_pnet->AddHiddenNode();
-
+         const ActivationCache cache = CacheActivations(valSet, valOuts);
 
-         // --- Gradient ascend ---
-         bool done = false;
-         for (size_t t = 0; !done; ++t) {
-            val_t alpha = m_RateFactory(t);
-
-            done = true;
-            for (size_t wInd = 0; wInd < pnode->GetWeightsCount(); ++wInd) {
-
-               // calculate the new node's outputs for each example
-               std::vector<val_t> nodeState(exCount); // [ex]
-               for (size_t ex = 0; ex < exCount; ++ex) {
-                  m_pnet->ComputeOutputs((valSet[ex])->data(), nullptr);
-                  nodeState[ex] = m_pnet->GetHiddenOutput(hiddenNodeCount);
-               }
-               val_t avgNodeState = std::accumulate(nodeState.cbegin(), nodeState.cend(), 0.0) / exCount;
-
-               // calculate dS/dw
-               val_t sprime = (val_t)0;
-               for (size_t output = 0; output < outputCount; ++output) {
+         std::vector<std::vector<val_t>> candidates(m_candidateCount);
+         for (std::vector<val_t>& weights : candidates)
+            weights = m_pnet->DrawHiddenWeights();
 
-                  val_t cor = 0;
-                  for (size_t ex = 0; ex < exCount; ++ex)
-                     cor += (nodeState[ex] - avgNodeState) * (states[ex][inputCount + hiddenNodeCount + output] - avgOutput[output]);
-                  val_t corSign = cor > 0 ? 1 : -1;
-
-                  for (size_t ex = 0; ex < exCount; ++ex) {
-                     val_t fprime = nodeState[ex] * (1 - nodeState[ex]);
-                     val_t i = wInd == 0 ? 1 : states[ex][wInd - 1]; // because of bias weight
-
-                     sprime += corSign * (errors[ex][output] - avgErrors[output]) * fprime * i;
-                  }
-               }
-               // update w by gradient ascend
-               val_t prevW = pnode->GetWeightAt(wInd);
-               val_t w = prevW + alpha * sprime;
-               pnode->SetWeightAt(wInd, w);
+         std::vector<val_t> scores(m_candidateCount);
+         concurrency::parallel_for((size_t)0, m_candidateCount, [this, &cache, &candidates, &scores](size_t c) {
+            scores[c] = TrainCandidate(cache, candidates[c].data());
+         });
 
-               // continue if at least one w changed by more than 1 %
-               if ((std::abs(w - prevW) / std::abs(prevW)) > 0.01) {
-                  done = false;
-               }
-            } // w
-         }
+         size_t best = std::max_element(scores.cbegin(), scores.cend()) - scores.cbegin();
+         m_pnet->AddHiddenNode(candidates[best].data());
       }
       virtual void InternalTrain(
-         const std::vector<const std::vector<val_t> *>& trainSet, const std::vector<const std::vector<val_t> *>& trainOuts,
-         const std::vector<const std::vector<val_t> *>& valSet, const std::vector<const std::vector<val_t> *>& valOuts)
+         const std::vector<const val_t *>& trainSet, const std::vector<const val_t *>& trainOuts,
+         const std::vector<const val_t *>& valSet, const std::vector<const val_t *>& valOuts)
       {
          auto pouts = std::make_unique<val_t[]>(m_pnet->GetOutputCount());
          val_t optErr, prevErr, lastNodeErr;
 
-         for (int t = 0; true; ++t) {
+         for (int t = 0; m_maxEpochs == 0 || (size_t)t < m_maxEpochs; ++t) {
 
             // Train output nodes using training set
             val_t alpha = m_RateFactory(t);
@@ -777,7 +1117,7 @@ namespace Processing
 
             if (t % 5 == 0) {
                // Compute error
-               val_t avgErr = GetAvgError(pouts.get(), valSet, valOuts);
+               val_t avgErr = GetAvgError(valSet, valOuts);
 
                if (t == 0) {
                   prevErr = lastNodeErr = optErr = avgErr;
@@ -802,81 +1142,1252 @@ namespace Processing
             }
          } // epoch
       }
+
+   private:
+      // One epoch of output training through m_poptimizer, on gradients accumulated over
+      // the whole training set or over batches of BATCH_SIZE, as the optimizer requires
+      void OptimizeOutputs(const std::vector<const val_t *>& trainSet,
+                           const std::vector<const val_t *>& trainOuts,
+                           val_t *pouts, val_t alpha)
+      {
+         const size_t inputCount = m_pnet->GetInputCount();
+         const size_t outputCount = m_pnet->GetOutputCount();
+         const size_t fanIn = inputCount + m_pnet->GetHiddenCount();
+         const size_t wlen = fanIn + 1;
+         if (!m_poptimizer || m_params.size() != outputCount * wlen) {
+            m_params.resize(outputCount * wlen);
+            m_grads.assign(outputCount * wlen, (val_t)0.0);
+            m_poptimizer = CreateOptimizer<val_t>(m_optimizerType, m_params.size());
+         }
+         const size_t batchSize = m_poptimizer->IsFullBatch() ? trainSet.size() : BATCH_SIZE;
+
+         std::vector<val_t> states(wlen);
+         states[0] = 1; // bias
+         for (size_t first = 0; first < trainSet.size(); first += batchSize) {
+            const size_t count = std::min(batchSize, trainSet.size() - first);
+            for (size_t ex = first; ex < first + count; ++ex) {
+               const val_t *in = trainSet[ex];
+               const val_t *out = trainOuts[ex];
+               m_pnet->ComputeStates(in, pouts);
+
+               std::copy(in, in + inputCount, states.begin() + 1);
+               for (size_t node = inputCount; node < fanIn; ++node)
+                  states[node + 1] = m_pnet->GetHiddenOutput(node - inputCount);
+               for (size_t i = 0; i < outputCount; ++i) {
+                  val_t a = pouts[i];
+                  val_t delta = -(out[i] - a) * a * (1 - a);
+                  Gemm<val_t>::Axpy(wlen, delta, states.data(), &m_grads[i * wlen]);
+               }
+            }
+
+            for (size_t i = 0; i < outputCount; ++i) {
+               auto pnode = m_pnet->GetOutputNode(i);
+               for (size_t wInd = 0; wInd < wlen; ++wInd)
+                  m_params[i * wlen + wInd] = pnode->GetWeightAt(wInd);
+            }
+            m_poptimizer->Step(m_params.data(), m_grads.data(), count, alpha);
+            for (size_t i = 0; i < outputCount; ++i) {
+               auto pnode = m_pnet->GetOutputNode(i);
+               for (size_t wInd = 0; wInd < wlen; ++wInd)
+                  pnode->SetWeightAt(wInd, m_params[i * wlen + wInd]);
+            }
+            std::fill(m_grads.begin(), m_grads.end(), (val_t)0.0);
+         }
+      }
+      // Units below the candidate are frozen, so their activations are computed once per example
+      // and every candidate weight then costs a few passes over exCount contiguous values
+      ActivationCache CacheActivations(const std::vector<const val_t *>& valSet, const std::vector<const val_t *>& valOuts)
+      {
+         const size_t inputCount = m_pnet->GetInputCount();
+         const size_t outputCount = m_pnet->GetOutputCount();
+         const size_t fanIn = inputCount + m_pnet->GetHiddenCount(); // candidate's fan-in, bias excluded
+         const size_t exCount = valSet.size();
+
+         ActivationCache cache = { exCount, fanIn, outputCount };
+         cache.fanInStates.resize(fanIn * exCount);
+         cache.errDevs.resize(outputCount * exCount);
+
+         std::vector<val_t> outs(outputCount);
+         for (size_t ex = 0; ex < exCount; ++ex) {
+            const val_t *in = valSet[ex];
+            const val_t *target = valOuts[ex];
+            m_pnet->ComputeStates(in, outs.data());
+
+            for (size_t input = 0; input < inputCount; ++input)
+               cache.fanInStates[input * exCount + ex] = in[input];
+            for (size_t node = inputCount; node < fanIn; ++node)
+               cache.fanInStates[node * exCount + ex] = m_pnet->GetHiddenOutput(node - inputCount);
+            for (size_t output = 0; output < outputCount; ++output) {
+               cache.errDevs[output * exCount + ex] = std::abs(outs[output] - target[output]);
+            }
+         }
+         for (size_t output = 0; output < outputCount; ++output) {
+            val_t *perr = &cache.errDevs[output * exCount];
+            const val_t avgErr = std::accumulate(perr, perr + exCount, (val_t)0.0) / exCount;
+            for (size_t ex = 0; ex < exCount; ++ex)
+               perr[ex] -= avgErr;
+         }
+         return cache;
+      }
+      // Gradient ascent on one candidate, weights laid out as by CCNetwork::DrawHiddenWeights().
+      // Returns the candidate's correlation with the residual errors, summed over outputs. Thread-safe.
+      val_t TrainCandidate(const ActivationCache& cache, val_t *weights) const
+      {
+         typedef Gemm<val_t> G;
+         const size_t exCount = cache.exCount, fanIn = cache.fanIn;
+         std::vector<val_t> netInputs(exCount), nodeStates(exCount), nodeDevs(exCount), errSum(exCount), grad(exCount);
+
+         auto ComputeNodeStates = [&]() {
+            for (size_t ex = 0; ex < exCount; ++ex)
+               nodeStates[ex] = SigmoidFunc<val_t>()(netInputs[ex]);
+            val_t avgNodeState = std::accumulate(nodeStates.cbegin(), nodeStates.cend(), (val_t)0.0) / exCount;
+            for (size_t ex = 0; ex < exCount; ++ex)
+               nodeDevs[ex] = nodeStates[ex] - avgNodeState;
+         };
+
+         bool done = false;
+         for (size_t t = 0; !done; ++t) {
+            val_t alpha = m_RateFactory(t);
+
+            // exact net inputs once per sweep, updated incrementally after each weight
+            std::fill(netInputs.begin(), netInputs.end(), weights[0]);
+            for (size_t i = 0; i < fanIn; ++i)
+               G::Axpy(exCount, weights[i + 1], &cache.fanInStates[i * exCount], netInputs.data());
+
+            done = true;
+            for (size_t wInd = 0; wInd <= fanIn; ++wInd) {
+               ComputeNodeStates();
+
+               // dS/dw = sum over outputs of sign(cor) * sum over examples of errDev * f' * input,
+               // cor being the correlation S scores the candidates by (Fahlman & Lebiere, 1990)
+               std::fill(errSum.begin(), errSum.end(), (val_t)0.0);
+               for (size_t output = 0; output < cache.outputCount; ++output) {
+                  val_t cor = G::Dot(nodeDevs.data(), &cache.errDevs[output * exCount], exCount);
+                  G::Axpy(exCount, cor > 0 ? (val_t)1 : (val_t)-1, &cache.errDevs[output * exCount], errSum.data());
+               }
+               for (size_t ex = 0; ex < exCount; ++ex)
+                  grad[ex] = errSum[ex] * nodeStates[ex] * (1 - nodeStates[ex]);
+               val_t sprime = wInd == 0 // because of bias weight
+                  ? std::accumulate(grad.cbegin(), grad.cend(), (val_t)0.0)
+                  : G::Dot(grad.data(), &cache.fanInStates[(wInd - 1) * exCount], exCount);
+
+               // update w by gradient ascend
+               val_t prevW = weights[wInd];
+               val_t w = prevW + alpha * sprime;
+               weights[wInd] = w;
+               if (wInd == 0) {
+                  for (size_t ex = 0; ex < exCount; ++ex)
+                     netInputs[ex] += w - prevW;
+               }
+               else {
+                  G::Axpy(exCount, w - prevW, &cache.fanInStates[(wInd - 1) * exCount], netInputs.data());
+               }
+
+               // continue if at least one w changed by more than 1 %
+               if ((std::abs(w - prevW) / std::abs(prevW)) > 0.01) {
+                  done = false;
+               }
+            } // w
+         }
+
+         ComputeNodeStates();
+         val_t score = 0;
+         for (size_t output = 0; output < cache.outputCount; ++output)
+            score += std::abs(G::Dot(nodeDevs.data(), &cache.errDevs[output * exCount], exCount));
+         return score;
+      }
    };
 
 #pragma endregion
 
 
-#pragma region C++/CX classes
+#pragma region Decision forests
 
+   // Random forest behind the network interface, trained and served by Classifier like the networks
    template <typename TData>
-   private ref class Classifier
+   class ForestNetwork : public INetwork<TData>
    {
       REQUIRES_FLOAT(TData);
 
-      std::mutex m_mut;
-      std::unique_ptr<INetwork<TData>> m_pNetwork;
+   public:
+      typedef TData val_t;
+      typedef ForestNetwork<TData> My_t;
+      typedef INetwork<TData> Base_t;
 
-      std::vector<std::vector<TData>> m_inputs;
-      std::vector<std::vector<TData>> m_outputs;
+   private:
+      RandomForest<TData> m_forest;
+      const ForestParams m_params;
 
-   internal:
-      Classifier() : m_pNetwork(nullptr)
+   public:
+      // outputs zeros until trained
+      ForestNetwork(size_t inN, size_t outN, const ForestParams& params = ForestParams())
+         : m_forest(inN, outN), m_params(params)
       { }
-      void CreateBPNetwork(int32 inN, int32 N, int32 outN, int32 L)
+      virtual size_t GetNodeCount() const noexcept
       {
-         std::lock_guard<std::mutex> lk(m_mut);
-         m_pNetwork = std::make_unique<BPNetwork<TData>>(inN, N, outN, L, &BottouWeightFactory<TData>);
+         return m_forest.GetNodeCount();
+      }
+      virtual size_t GetInputCount() const noexcept
+      {
+         return m_forest.GetInputCount();
+      }
+      virtual size_t GetOutputCount() const noexcept
+      {
+         return m_forest.GetOutputCount();
+      }
+      virtual void ComputeOutputs(const TData *pinputs, OUT TData *poutputs) const
+      {
+         m_forest.Predict(pinputs, poutputs);
+      }
+      virtual void ComputeBatch(const TData *pinputs, size_t count, OUT TData *poutputs) const
+      {
+         m_forest.PredictBatch(pinputs, count, poutputs);
+      }
+      // trees have no weights to optimize
+      virtual std::unique_ptr<ITrainer<TData>> CreateTrainer(OptimizerType optimizer = OptimizerType::GradientDescent)
+      {
+         return std::make_unique<Trainer<My_t>>(this);
+      }
+      virtual std::unique_ptr<INetwork<TData>> Clone() const
+      {
+         return std::make_unique<My_t>(*this);
+      }
+      const ForestParams& GetParams() const noexcept
+      {
+         return m_params;
+      }
+      RandomForest<TData>& GetForest() noexcept
+      {
+         return m_forest;
+      }
+   };
+
+   template <typename TData>
+   class Trainer<ForestNetwork<TData>> : public ITrainer<TData>
+   {
+      ForestNetwork<TData> *m_pnet;
+
+   public:
+      using ITrainer<TData>::Train;
+
+      explicit Trainer(ForestNetwork<TData> *pnetwork) : m_pnet(pnetwork)
+      { }
+      // grows the whole forest anew on all examples, no validation set is held out
+      virtual void Train(const std::vector<const TData *>& inputs, const std::vector<const TData *>& outputs)
+      {
+         m_pnet->GetForest().Fit(inputs, outputs, m_pnet->GetParams());
+      }
+      virtual void SetLearningRate(std::function<TData(int)> RateFactory)
+      { }
+      virtual void SetMaxEpochs(size_t maxEpochs)
+      { }
+      virtual void Update(const std::vector<const TData *>& inputs, const std::vector<const TData *>& outputs, TData rate)
+      {
+         throw UpdateNotSupportedException(); // forests are only grown by Train
+      }
+   };
+
+#pragma endregion
+
+
+#pragma region Linear classifiers
+
+   enum class LinearMethod
+   {
+      ShrinkageLda,
+      Svm
+   };
+
+   // Shrinkage LDA or one-vs-rest linear SVMs behind the network interface, fitted in closed form or
+   // in a few passes over the examples, for when training time matters more than accuracy
+   template <typename TData>
+   class LinearNetwork : public INetwork<TData>
+   {
+      REQUIRES_FLOAT(TData);
+
+   public:
+      typedef TData val_t;
+      typedef LinearNetwork<TData> My_t;
+      typedef INetwork<TData> Base_t;
+
+   private:
+      LinearModel<TData> m_model;
+      const LinearMethod m_method;
+      const TData m_cost; // SVM only
+
+   public:
+      // outputs the same for every input until trained
+      LinearNetwork(size_t inN, size_t outN, LinearMethod method, TData cost = 1.0)
+         : m_model(inN, outN, method == LinearMethod::ShrinkageLda ? LinearOutput::Softmax : LinearOutput::Sigmoid),
+         m_method(method), m_cost(cost)
+      { }
+      virtual size_t GetNodeCount() const noexcept
+      {
+         return m_model.GetOutputCount();
+      }
+      virtual size_t GetInputCount() const noexcept
+      {
+         return m_model.GetInputCount();
+      }
+      virtual size_t GetOutputCount() const noexcept
+      {
+         return m_model.GetOutputCount();
+      }
+      virtual void ComputeOutputs(const TData *pinputs, OUT TData *poutputs) const
+      {
+         m_model.Predict(pinputs, poutputs);
+      }
+      virtual void ComputeBatch(const TData *pinputs, size_t count, OUT TData *poutputs) const
+      {
+         m_model.PredictBatch(pinputs, count, poutputs);
+      }
+      // neither method has use for an optimizer
+      virtual std::unique_ptr<ITrainer<TData>> CreateTrainer(OptimizerType optimizer = OptimizerType::GradientDescent)
+      {
+         return std::make_unique<Trainer<My_t>>(this);
+      }
+      virtual std::unique_ptr<INetwork<TData>> Clone() const
+      {
+         return std::make_unique<My_t>(*this);
+      }
+      LinearMethod GetMethod() const noexcept
+      {
+         return m_method;
+      }
+      TData GetCost() const noexcept
+      {
+         return m_cost;
+      }
+      LinearModel<TData>& GetModel() noexcept
+      {
+         return m_model;
+      }
+   };
+
+   template <typename TData>
+   class Trainer<LinearNetwork<TData>> : public ITrainer<TData>
+   {
+      LinearNetwork<TData> *m_pnet;
+
+   public:
+      using ITrainer<TData>::Train;
+
+      explicit Trainer(LinearNetwork<TData> *pnetwork) : m_pnet(pnetwork)
+      { }
+      // refits on all examples
+      virtual void Train(const std::vector<const TData *>& inputs, const std::vector<const TData *>& outputs)
+      {
+         if (m_pnet->GetMethod() == LinearMethod::ShrinkageLda)
+            FitShrinkageLda(inputs, outputs, &m_pnet->GetModel());
+         else
+            FitLinearSvm(inputs, outputs, m_pnet->GetCost(), &m_pnet->GetModel());
+      }
+      virtual void SetLearningRate(std::function<TData(int)> RateFactory)
+      { }
+      virtual void SetMaxEpochs(size_t maxEpochs)
+      { }
+      virtual void Update(const std::vector<const TData *>& inputs, const std::vector<const TData *>& outputs, TData rate)
+      {
+         throw UpdateNotSupportedException(); // linear classifiers are only fitted by Train
+      }
+   };
+
+#pragma endregion
+
+
+#pragma region Quantized inference
+
+   // Sigmoid outputs in 7 bits, the range DotU7S8 expects
+   class SigmoidTable
+   {
+      static constexpr int SIZE = 4096;
+      static constexpr float RANGE = 8.0f; // saturated beyond +-RANGE
+
+      uint8_t m_table[SIZE + 1];
+
+      SigmoidTable()
+      {
+         for (int i = 0; i <= SIZE; ++i) {
+            double z = -RANGE + 2.0 * RANGE * i / SIZE;
+            m_table[i] = (uint8_t)std::lround(127.0 / (1.0 + std::exp(-z)));
+         }
+      }
+
+   public:
+      static const SigmoidTable& Get()
+      {
+         static const SigmoidTable table;
+         return table;
+      }
+      uint8_t operator()(float z) const
+      {
+         float pos = (z + RANGE) * (SIZE / (2.0f * RANGE));
+         int i = (int)(std::min(std::max(pos, 0.0f), (float)SIZE) + 0.5f);
+         return m_table[i];
+      }
+   };
+
+   // Read-only int8 export of a trained network: weights in 8 bits with one scale per layer,
+   // inputs and hidden activations in 7 bits, table sigmoid for hidden units.
+   // Only the output layer is computed in floating point.
+   template <typename TData>
+   class QuantizedNetwork : public INetwork<TData>
+   {
+   public:
+      typedef QuantizedNetwork<TData> My_t;
+
+   private:
+      static constexpr int INPUT_ZERO = 64; // quantized inputs are offset into [0, 127]
+
+      // A set of units reading the first inCount inputs followed by hidCount hidden activations
+      // starting at hidFirst. Hidden layers write their activations from outFirst on.
+      struct Layer
+      {
+         size_t rows, inCount, hidFirst, hidCount, outFirst;
+         TData scale;                   // weight = scale * quantized weight
+         std::vector<int8_t> weights;   // [row][inCount + hidCount]
+         std::vector<int32_t> zeroSums; // [row], INPUT_ZERO * sum of the input weights
+         std::vector<TData> biases;     // [row]
+      };
+
+      const size_t IN_N, OUT_N;
+      TData m_inputScale;
+      size_t m_hiddenCount;
+      std::vector<Layer> m_layers; // the last one is the output layer
+
+   public:
+      // inputRange - largest input magnitude represented exactly, larger values are clipped
+      QuantizedNetwork(const BPNetwork<TData>& net, TData inputRange)
+         : IN_N(net.GetInputCount()), OUT_N(net.GetOutputCount()), m_inputScale(inputRange / (INPUT_ZERO - 1)), m_hiddenCount(0)
+      {
+         for (size_t layer = 0; layer < net.GetLayerCount(); ++layer) {
+            const size_t size = net.GetLayerSize(layer), fanIn = net.GetFanIn(layer);
+            const TData *pw = net.GetLayerWeights(layer);
+            std::vector<const TData *> rows(size);
+            for (size_t node = 0; node < size; ++node)
+               rows[node] = pw + node * fanIn;
+
+            const bool isOutput = layer == net.GetLayerCount() - 1;
+            if (layer == 0)
+               AddLayer(rows, net.GetLayerBiases(layer), fanIn, 0, 0, isOutput);
+            else
+               AddLayer(rows, net.GetLayerBiases(layer), 0, m_hiddenCount - fanIn, fanIn, isOutput);
+         }
+      }
+      QuantizedNetwork(const CCNetwork<TData>& net, TData inputRange)
+         : IN_N(net.GetInputCount()), OUT_N(net.GetOutputCount()), m_inputScale(inputRange / (INPUT_ZERO - 1)), m_hiddenCount(0)
+      {
+         // every hidden unit is a layer of its own, reading all inputs and the units before it
+         const size_t H = net.GetHiddenCount();
+         std::vector<TData> weights;
+         for (size_t i = 0; i < H; ++i) {
+            const auto *pnode = net.GetHiddenNode(i);
+            TData bias = NodeWeights(pnode, &weights);
+            AddLayer({ weights.data() }, &bias, IN_N, 0, i, false);
+         }
+
+         std::vector<std::vector<TData>> outWeights(OUT_N);
+         std::vector<const TData *> rows(OUT_N);
+         std::vector<TData> biases(OUT_N);
+         for (size_t i = 0; i < OUT_N; ++i) {
+            biases[i] = NodeWeights(net.GetOutputNode(i), &outWeights[i]);
+            rows[i] = outWeights[i].data();
+         }
+         AddLayer(rows, biases.data(), IN_N, 0, H, true);
+      }
+
+      virtual size_t GetNodeCount() const noexcept
+      {
+         return m_hiddenCount + OUT_N;
+      }
+      virtual size_t GetInputCount() const noexcept
+      {
+         return IN_N;
+      }
+      virtual size_t GetOutputCount() const noexcept
+      {
+         return OUT_N;
+      }
+      virtual void ComputeOutputs(const TData *pinputs, OUT TData *poutputs) const
+      {
+         assert(pinputs != nullptr);
+
+         thread_local std::vector<uint8_t> inputs, hidden;
+         thread_local std::vector<TData> outputs;
+         inputs.resize(IN_N);
+         hidden.resize(m_hiddenCount);
+         outputs.resize(OUT_N);
+
+         const TData invScale = (TData)1.0 / m_inputScale;
+         for (size_t i = 0; i < IN_N; ++i) {
+            TData q = std::round(pinputs[i] * invScale) + INPUT_ZERO;
+            inputs[i] = (uint8_t)std::min(std::max(q, (TData)0.0), (TData)(2 * INPUT_ZERO - 1));
+         }
+
+         const SigmoidTable& Sigmoid = SigmoidTable::Get();
+         for (size_t l = 0; l < m_layers.size(); ++l) {
+            const Layer& layer = m_layers[l];
+            const bool isOutput = l == m_layers.size() - 1;
+            const size_t stride = layer.inCount + layer.hidCount;
+
+            for (size_t row = 0; row < layer.rows; ++row) {
+               const int8_t *pw = layer.weights.data() + row * stride;
+               int32_t accIn = DotU7S8(inputs.data(), pw, layer.inCount) - layer.zeroSums[row];
+               int32_t accHid = DotU7S8(hidden.data() + layer.hidFirst, pw + layer.inCount, layer.hidCount);
+               TData z = layer.scale * (m_inputScale * accIn + accHid * (TData)(1.0 / 127.0)) + layer.biases[row];
+
+               if (isOutput)
+                  outputs[row] = (TData)1.0 / ((TData)1.0 + std::exp(-z));
+               else
+                  hidden[layer.outFirst + row] = Sigmoid((float)z);
+            }
+         }
+
+         if (poutputs)
+            std::copy(outputs.cbegin(), outputs.cend(), poutputs);
+      }
+      virtual std::unique_ptr<ITrainer<TData>> CreateTrainer(OptimizerType optimizer = OptimizerType::GradientDescent)
+      {
+         throw std::logic_error("quantized networks cannot be trained");
+      }
+      virtual std::unique_ptr<INetwork<TData>> Clone() const
+      {
+         return std::unique_ptr<INetwork<TData>>(new My_t(*this));
+      }
+
+      size_t GetWeightBytes() const noexcept
+      {
+         size_t bytes = 0;
+         for (const Layer& layer : m_layers)
+            bytes += layer.weights.size() + layer.zeroSums.size() * sizeof(int32_t) + layer.biases.size() * sizeof(TData);
+         return bytes;
+      }
+      // size of the same weights and biases in floating point
+      size_t GetFloatWeightBytes() const noexcept
+      {
+         size_t bytes = 0;
+         for (const Layer& layer : m_layers)
+            bytes += (layer.weights.size() + layer.biases.size()) * sizeof(TData);
+         return bytes;
+      }
+
+   private:
+      // rows[i] - inCount + hidCount float weights of unit i; the output layer must be added last
+      void AddLayer(const std::vector<const TData *>& rows, const TData *pbiases, size_t inCount, size_t hidFirst, size_t hidCount,
+                    bool isOutput)
+      {
+         Layer layer;
+         layer.rows = rows.size();
+         layer.inCount = inCount;
+         layer.hidFirst = hidFirst;
+         layer.hidCount = hidCount;
+         layer.outFirst = m_hiddenCount;
+
+         const size_t stride = inCount + hidCount;
+         TData maxAbs = 0.0;
+         for (const TData *prow : rows) {
+            for (size_t i = 0; i < stride; ++i)
+               maxAbs = std::max(maxAbs, std::abs(prow[i]));
+         }
+         layer.scale = maxAbs > 0 ? maxAbs / 127 : (TData)1.0;
+
+         layer.weights.resize(layer.rows * stride);
+         layer.zeroSums.resize(layer.rows);
+         layer.biases.assign(pbiases, pbiases + layer.rows);
+         for (size_t row = 0; row < layer.rows; ++row) {
+            int32_t sum = 0;
+            for (size_t i = 0; i < stride; ++i) {
+               int8_t q = (int8_t)std::lround(rows[row][i] / layer.scale);
+               layer.weights[row * stride + i] = q;
+               if (i < inCount)
+                  sum += q;
+            }
+            layer.zeroSums[row] = INPUT_ZERO * sum;
+         }
+
+         if (!isOutput)
+            m_hiddenCount += layer.rows;
+         m_layers.push_back(std::move(layer));
+      }
+      template <typename TNode>
+      static TData NodeWeights(const TNode *pnode, std::vector<TData> *pweights)
+      {
+         pweights->resize(pnode->GetWeightsCount() - 1);
+         for (size_t i = 1; i < pnode->GetWeightsCount(); ++i)
+            (*pweights)[i - 1] = pnode->GetWeightAt(i);
+         return pnode->GetWeightAt(0);
+      }
+   };
+
+   template <typename TData>
+   struct QuantizationError
+   {
+      TData meanAbsDelta; // over all outputs of all examples
+      TData maxAbsDelta;
+      TData agreement;    // fraction of examples where both networks pick the same output
+      size_t floatBytes;  // weights and biases of the reference
+      size_t quantizedBytes;
+   };
+
+   // Calibration for Quantize(), the largest input magnitude of the examples
+   template <typename TData>
+   inline TData InputRange(const Dataset<TData>& examples)
+   {
+      TData range = 0.0;
+      for (size_t ex = 0; ex < examples.GetCount(); ++ex) {
+         const TData *pin = examples.GetInput(ex);
+         for (size_t i = 0; i < examples.GetInputCount(); ++i)
+            range = std::max(range, std::abs(pin[i]));
+      }
+      return range > 0 ? range : (TData)4.0; // normalized inputs
+   }
+
+   // Quantized export of a BPNetwork or CCNetwork
+   template <typename TData>
+   inline std::unique_ptr<QuantizedNetwork<TData>> Quantize(const INetwork<TData>& net, TData range)
+   {
+      if (auto pbp = dynamic_cast<const BPNetwork<TData> *>(&net))
+         return std::make_unique<QuantizedNetwork<TData>>(*pbp, range);
+      if (auto pcc = dynamic_cast<const CCNetwork<TData> *>(&net))
+         return std::make_unique<QuantizedNetwork<TData>>(*pcc, range);
+      throw std::invalid_argument("unsupported network type");
+   }
+
+   template <typename TData>
+   inline QuantizationError<TData> CompareOutputs(const INetwork<TData>& reference, const INetwork<TData>& other,
+                                                  const Dataset<TData>& examples)
+   {
+      const size_t outN = reference.GetOutputCount();
+      std::vector<TData> a(outN), b(outN);
+      QuantizationError<TData> res = { 0, 0, 1, 0, 0 };
+      if (examples.GetCount() == 0)
+         return res;
+
+      size_t agreeing = 0;
+      for (size_t ex = 0; ex < examples.GetCount(); ++ex) {
+         reference.ComputeOutputs(examples.GetInput(ex), a.data());
+         other.ComputeOutputs(examples.GetInput(ex), b.data());
+         for (size_t i = 0; i < outN; ++i) {
+            TData delta = std::abs(a[i] - b[i]);
+            res.meanAbsDelta += delta;
+            res.maxAbsDelta = std::max(res.maxAbsDelta, delta);
+         }
+         if (std::max_element(a.cbegin(), a.cend()) - a.cbegin() == std::max_element(b.cbegin(), b.cend()) - b.cbegin())
+            agreeing++;
+      }
+      res.meanAbsDelta /= examples.GetCount() * outN;
+      res.agreement = (TData)agreeing / examples.GetCount();
+      return res;
+   }
+
+#pragma endregion
+
+
+#pragma region Model files
+
+   // whether SaveNetwork() can write net, to be checked before overwriting anything
+   template <typename TData>
+   inline bool CanSaveNetwork(const INetwork<TData>& net)
+   {
+      return dynamic_cast<const BPNetwork<TData> *>(&net) || dynamic_cast<const CCNetwork<TData> *>(&net);
+   }
+
+   // BPNetwork or CCNetwork, see ModelFile.h for the format
+   template <typename TData>
+   inline void SaveNetwork(const INetwork<TData>& net, std::ostream& out, InputNormalization normalization)
+   {
+      if (auto pbp = dynamic_cast<const BPNetwork<TData> *>(&net))
+         return pbp->Save(out, normalization);
+      if (auto pcc = dynamic_cast<const CCNetwork<TData> *>(&net))
+         return pcc->Save(out, normalization);
+      throw std::invalid_argument("unsupported network type");
+   }
+
+   // A back-propagation network is used in place from the mapped file, which stays mapped while the network lives
+   template <typename TData>
+   inline std::unique_ptr<INetwork<TData>> LoadNetwork(const MappedFile::PathChar *path, OUT InputNormalization *pnormalization = nullptr)
+   {
+      auto pfile = std::make_shared<MappedFile>(path);
+      const ModelFileHeader& header = pfile->GetModelHeader();
+      if (pnormalization)
+         *pnormalization = header.normalization;
+
+      switch (header.type) {
+      case ModelType::BackPropagation:
+         return BPNetwork<TData>::Load(pfile);
+      case ModelType::CascadeCorrelation:
+         return CCNetwork<TData>::Load(*pfile, &BottouWeightFactory<TData>);
+      default:
+         throw std::invalid_argument("unsupported network type");
+      }
+   }
+
+#pragma endregion
+
+#pragma region Model selection
+
+   struct ModelConfig
+   {
+      ModelType type;
+      size_t layerSize;       // back-propagation only
+      size_t layerCount;      // back-propagation only
+      OptimizerType optimizer;
+      size_t schedule;        // index into ModelGrid::rateSchedules
+   };
+
+   // Every combination is evaluated; cascade-correlation networks ignore the layer dimensions
+   template <typename TData>
+   struct ModelGrid
+   {
+      std::vector<ModelType> types = { ModelType::BackPropagation };
+      std::vector<size_t> layerSizes;
+      std::vector<size_t> layerCounts;
+      std::vector<OptimizerType> optimizers = { OptimizerType::GradientDescent };
+      std::vector<std::function<TData(int)>> rateSchedules = { &DefaultLearningRate<TData> };
+      size_t folds = 5;
+      size_t maxEpochs = 0; // per training, 0 leaves it to early stopping, which may never stop on separable data
+      uint32_t seed = 0;
+
+      std::vector<ModelConfig> GetConfigs() const
+      {
+         std::vector<ModelConfig> configs;
+         for (ModelType type : types) {
+            for (OptimizerType optimizer : optimizers) {
+               for (size_t schedule = 0; schedule < rateSchedules.size(); ++schedule) {
+                  if (type == ModelType::CascadeCorrelation) {
+                     configs.push_back({ type, 0, 0, optimizer, schedule });
+                     continue;
+                  }
+                  for (size_t layerSize : layerSizes) {
+                     for (size_t layerCount : layerCounts)
+                        configs.push_back({ type, layerSize, layerCount, optimizer, schedule });
+                  }
+               }
+            }
+         }
+         return configs;
+      }
+   };
+
+   template <typename TData>
+   struct ModelScore
+   {
+      ModelConfig config;
+      TData accuracy;             // fraction of held-out examples whose largest output matches the target's, mean over folds
+      TData accuracyDeviation;    // standard deviation over folds
+      double trainSeconds;        // mean per fold
+      double latencyMicroseconds; // ComputeOutputs() time per example, measured with nothing else running
+   };
+
+   template <typename TData>
+   struct ModelSelection
+   {
+      std::vector<ModelScore<TData>> scores; // in ModelGrid::GetConfigs() order
+      size_t best;
+      std::unique_ptr<INetwork<TData>> pmodel; // best configuration trained on all examples
+   };
+
+   template <typename TData>
+   inline std::unique_ptr<INetwork<TData>> CreateNetwork(const ModelConfig& config, size_t inN, size_t outN, uint32_t seed)
+   {
+      SeededWeightFactory<TData> factory(seed);
+      if (config.type == ModelType::CascadeCorrelation)
+         return std::make_unique<CCNetwork<TData>>(inN, outN, factory);
+      return std::make_unique<BPNetwork<TData>>(inN, config.layerSize, outN, config.layerCount, factory);
+   }
+
+   // k-fold cross-validation of every configuration in the grid. All (configuration, fold) jobs run
+   // concurrently, each with its own weight seed, so results don't depend on scheduling.
+   // Latencies are measured afterwards, one configuration at a time, on the networks of the first fold.
+   template <typename TData>
+   inline ModelSelection<TData> SelectModel(const ModelGrid<TData>& grid, const Dataset<TData>& examples)
+   {
+      typedef std::chrono::steady_clock Clock;
+      const std::vector<ModelConfig> configs = grid.GetConfigs();
+      const size_t K = grid.folds, exCount = examples.GetCount();
+      if (configs.empty() || K < 2 || exCount < K)
+         throw std::invalid_argument("empty grid or fewer examples than folds");
+      const size_t inN = examples.GetInputCount(), outN = examples.GetOutputCount();
+
+      // example i of the shuffled order is held out in fold i % K
+      std::vector<size_t> order(exCount);
+      std::iota(order.begin(), order.end(), 0);
+      std::shuffle(order.begin(), order.end(), std::mt19937(grid.seed));
+
+      struct Job
+      {
+         TData accuracy;
+         double trainSeconds;
+         std::unique_ptr<INetwork<TData>> pnet; // kept for the first fold only
+      };
+      std::vector<Job> jobs(configs.size() * K);
+
+      concurrency::parallel_for((size_t)0, jobs.size(), [&](size_t job) {
+         const ModelConfig& config = configs[job / K];
+         const size_t fold = job % K;
+
+         std::vector<const TData *> trainIns, trainOuts;
+         std::vector<size_t> held;
+         for (size_t i = 0; i < exCount; ++i) {
+            if (i % K == fold) {
+               held.push_back(order[i]);
+            }
+            else {
+               trainIns.push_back(examples.GetInput(order[i]));
+               trainOuts.push_back(examples.GetOutput(order[i]));
+            }
+         }
+
+         auto pnet = CreateNetwork<TData>(config, inN, outN, grid.seed + (uint32_t)job + 1);
+         auto ptrainer = pnet->CreateTrainer(config.optimizer);
+         ptrainer->SetLearningRate(grid.rateSchedules[config.schedule]);
+         ptrainer->SetMaxEpochs(grid.maxEpochs);
+         Clock::time_point start = Clock::now();
+         ptrainer->Train(trainIns, trainOuts);
+         Clock::time_point trained = Clock::now();
+
+         std::vector<TData> res(outN);
+         size_t correct = 0;
+         for (size_t ex : held) {
+            const TData *ptarget = examples.GetOutput(ex);
+            pnet->ComputeOutputs(examples.GetInput(ex), res.data());
+            correct += std::max_element(res.cbegin(), res.cend()) - res.cbegin() ==
+                       std::max_element(ptarget, ptarget + outN) - ptarget;
+         }
+
+         jobs[job].accuracy = (TData)correct / held.size();
+         jobs[job].trainSeconds = std::chrono::duration<double>(trained - start).count();
+         if (fold == 0)
+            jobs[job].pnet = std::move(pnet);
+      });
+
+      // timings taken while the other jobs ran would mostly measure the contention
+      std::vector<size_t> firstHeld;
+      for (size_t i = 0; i < exCount; i += K)
+         firstHeld.push_back(order[i]);
+      std::vector<double> latencies(configs.size());
+      for (size_t c = 0; c < configs.size(); ++c) {
+         const INetwork<TData>& net = *jobs[c * K].pnet;
+         std::vector<TData> res(outN);
+         double fastest = std::numeric_limits<double>::infinity();
+         for (int run = 0; run < 3; ++run) {
+            Clock::time_point start = Clock::now();
+            for (size_t ex : firstHeld)
+               net.ComputeOutputs(examples.GetInput(ex), res.data());
+            fastest = std::min(fastest, std::chrono::duration<double, std::micro>(Clock::now() - start).count());
+         }
+         latencies[c] = fastest / firstHeld.size();
+      }
+
+      ModelSelection<TData> selection = { {}, 0, nullptr };
+      for (size_t c = 0; c < configs.size(); ++c) {
+         ModelScore<TData> score = { configs[c], 0, 0, 0.0, 0.0 };
+         for (size_t fold = 0; fold < K; ++fold) {
+            const Job& job = jobs[c * K + fold];
+            score.accuracy += job.accuracy / K;
+            score.trainSeconds += job.trainSeconds / K;
+         }
+         score.latencyMicroseconds = latencies[c];
+         for (size_t fold = 0; fold < K; ++fold) {
+            TData dev = jobs[c * K + fold].accuracy - score.accuracy;
+            score.accuracyDeviation += dev * dev;
+         }
+         score.accuracyDeviation = std::sqrt(score.accuracyDeviation / (K - 1));
+         selection.scores.push_back(score);
+
+         // the faster of equally accurate configurations
+         const ModelScore<TData>& best = selection.scores[selection.best];
+         if (score.accuracy > best.accuracy || (score.accuracy == best.accuracy && score.latencyMicroseconds < best.latencyMicroseconds))
+            selection.best = c;
+      }
+
+      const ModelConfig& best = configs[selection.best];
+      selection.pmodel = CreateNetwork<TData>(best, inN, outN, grid.seed);
+      auto ptrainer = selection.pmodel->CreateTrainer(best.optimizer);
+      ptrainer->SetLearningRate(grid.rateSchedules[best.schedule]);
+      ptrainer->SetMaxEpochs(grid.maxEpochs);
+      ptrainer->Train(examples);
+      return selection;
+   }
+
+#pragma endregion
+
+#pragma region Online learning
+
+   // The most recent examples, rehearsed alongside new ones so that online updates don't forget the rest
+   template <typename TData>
+   class ReplayBuffer
+   {
+      REQUIRES_FLOAT(TData);
+
+      const size_t m_capacity;
+      std::vector<std::vector<TData>> m_inputs;
+      std::vector<std::vector<TData>> m_outputs;
+      size_t m_next; // slot overwritten next once full
+      std::mt19937 m_engine;
+
+   public:
+      explicit ReplayBuffer(size_t capacity, std::mt19937::result_type seed = 0)
+         : m_capacity(std::max<size_t>(capacity, 1)), m_next(0), m_engine(seed)
+      { }
+      size_t GetSize() const noexcept
+      {
+         return m_inputs.size();
+      }
+      void Add(std::vector<TData> input, std::vector<TData> output)
+      {
+         if (m_inputs.size() < m_capacity) {
+            m_inputs.emplace_back(std::move(input));
+            m_outputs.emplace_back(std::move(output));
+            return;
+         }
+         m_inputs[m_next] = std::move(input);
+         m_outputs[m_next] = std::move(output);
+         m_next = (m_next + 1) % m_capacity;
+      }
+      // appends count examples drawn uniformly with replacement, none while empty
+      void Sample(size_t count, OUT std::vector<const TData *> *pinputs, OUT std::vector<const TData *> *poutputs)
+      {
+         if (m_inputs.empty())
+            return;
+         std::uniform_int_distribution<size_t> pick(0, m_inputs.size() - 1);
+         for (size_t n = 0; n < count; ++n) {
+            size_t i = pick(m_engine);
+            pinputs->push_back(m_inputs[i].data());
+            poutputs->push_back(m_outputs[i].data());
+         }
+      }
+   };
+
+#pragma endregion
+
+
+#pragma region C++/CX classes
+
+   template <typename TData>
+   private ref class Classifier
+   {
+      REQUIRES_FLOAT(TData);
+
+      std::mutex m_mut;        // guards the examples
+      std::mutex m_trainMut;   // one training at a time
+      std::mutex m_publishMut; // guards m_generation and m_inputRange, orders the replacements of m_pModel and m_pServing
+      std::mutex m_onlineMut;  // guards the online learning state
+
+      // Published models, read with atomic operations only. Classification never waits:
+      // training works on a clone and swaps it in when done. m_pServing is what classification uses,
+      // either m_pModel itself or its quantized export.
+      std::shared_ptr<const INetwork<TData>> m_pModel;
+      std::shared_ptr<const INetwork<TData>> m_pServing;
+      unsigned m_generation; // incremented whenever m_pModel is replaced by other than an online update
+      std::atomic<bool> m_quantized;
+      TData m_inputRange; // quantization calibration, refreshed by Quantize() and Train() but not by online updates
+      std::atomic<OptimizerType> m_optimizer;
+
+      Dataset<TData> m_examples; // normalized on arrival
+
+      // Online learning works on a private copy of the model of m_onlineGeneration and publishes clones of it
+      std::unique_ptr<INetwork<TData>> m_pOnline;
+      std::unique_ptr<ITrainer<TData>> m_pOnlineTrainer;
+      unsigned m_onlineGeneration;
+      ReplayBuffer<TData> m_replay;   // the last 512 examples
+      size_t m_onlineSteps, m_onlineBatch;
+      TData m_onlineRate;
+
+   internal:
+      Classifier() : m_pModel(nullptr), m_pServing(nullptr), m_generation(0), m_quantized(false), m_inputRange((TData)4.0), m_optimizer(OptimizerType::GradientDescent),
+         m_onlineGeneration(0), m_replay(512), m_onlineSteps(4), m_onlineBatch(8), m_onlineRate((TData)0.1)
+      { }
+      void CreateBPNetwork(int32 inN, int32 N, int32 outN, int32 L)
+      {
+         Publish(std::make_shared<BPNetwork<TData>>(inN, N, outN, L, &BottouWeightFactory<TData>));
       }
       void CreateCCNetwork(int32 inN, int32 outN)
       {
-         std::lock_guard<std::mutex> lk(m_mut);
-         m_pNetwork = std::make_unique<CCNetwork<TData>>(inN, outN, &BottouWeightFactory<TData>);
+         Publish(std::make_shared<CCNetwork<TData>>(inN, outN, &BottouWeightFactory<TData>));
+      }
+      void CreateForest(int32 inN, int32 outN, int32 treeCount, int32 maxDepth)
+      {
+         ForestParams params;
+         params.treeCount = treeCount;
+         params.maxDepth = maxDepth;
+         Publish(std::make_shared<ForestNetwork<TData>>(inN, outN, params));
+      }
+      void CreateLinear(int32 inN, int32 outN, LinearMethod method, TData cost)
+      {
+         Publish(std::make_shared<LinearNetwork<TData>>(inN, outN, method, cost));
       }
       void AddExample(const Array<TData>^ input, const Array<TData>^ output)
       {
-         std::lock_guard<std::mutex> lk(m_mut);
-         assert(input->Length == m_pNetwork->GetInputCount());
-         assert(output->Length == m_pNetwork->GetOutputCount());
+         std::vector<TData> in, out;
+         StoreExample(input, output, &in, &out);
+      }
+      // Adds the example and adapts the model to it right away, with m_onlineSteps updates on the new example
+      // and m_onlineBatch - 1 examples from the replay buffer each. Costs a few batch gradients rather than
+      // a Train(), which remains the way to fit all examples.
+      void Learn(const Array<TData>^ input, const Array<TData>^ output)
+      {
+         std::vector<TData> in, out;
+         StoreExample(input, output, &in, &out);
+
+         std::lock_guard<std::mutex> onlineLk(m_onlineMut);
+         {
+            // start over from whatever replaced the model since the last update
+            std::lock_guard<std::mutex> publishLk(m_publishMut);
+            if (!m_pOnline || m_onlineGeneration != m_generation) {
+               m_pOnline = std::atomic_load(&m_pModel)->Clone();
+               // iRprop- and Quickprop adapt their steps to full-batch gradients, small replay batches would mislead them
+               const OptimizerType optimizer = m_optimizer == OptimizerType::Adam ? OptimizerType::Adam : OptimizerType::GradientDescent;
+               m_pOnlineTrainer = m_pOnline->CreateTrainer(optimizer);
+               m_onlineGeneration = m_generation;
+            }
+         }
 
-         std::vector<TData> in(begin(input), end(input));
-         std::vector<TData> out(begin(output), end(output));
-         Normalize(&in);
+         std::vector<const TData *> batchIns, batchOuts;
+         try {
+            for (size_t step = 0; step < m_onlineSteps; ++step) {
+               batchIns.assign(1, in.data());
+               batchOuts.assign(1, out.data());
+               m_replay.Sample(m_onlineBatch - 1, &batchIns, &batchOuts);
+               m_pOnlineTrainer->Update(batchIns, batchOuts, m_onlineRate);
+            }
+         }
+         catch (const UpdateNotSupportedException&) {
+            // forests and linear classifiers, the example is kept for the next Train()
+            m_pOnline.reset();
+            throw ref new NotImplementedException();
+         }
+         m_replay.Add(std::move(in), std::move(out));
 
-         m_inputs.emplace_back(std::move(in));
-         m_outputs.emplace_back(std::move(out));
+         std::shared_ptr<const INetwork<TData>> pupdated = m_pOnline->Clone();
+         std::lock_guard<std::mutex> publishLk(m_publishMut);
+         if (m_onlineGeneration == m_generation) {
+            std::atomic_store(&m_pModel, pupdated);
+            Serve(pupdated);
+         }
+      }
+      void ConfigureOnlineLearning(size_t stepsPerExample, size_t batchSize, TData rate)
+      {
+         std::lock_guard<std::mutex> onlineLk(m_onlineMut);
+         m_onlineSteps = stepsPerExample;
+         m_onlineBatch = std::max<size_t>(batchSize, 1);
+         m_onlineRate = rate;
       }
       void Train()
       {
-         std::lock_guard<std::mutex> lk(m_mut);
-         auto ptrainer = m_pNetwork->CreateTrainer();
-         ptrainer->Train(m_inputs, m_outputs);
+         std::lock_guard<std::mutex> trainLk(m_trainMut);
+         std::shared_ptr<const INetwork<TData>> psnapshot;
+         unsigned generation;
+         {
+            std::lock_guard<std::mutex> publishLk(m_publishMut);
+            psnapshot = std::atomic_load(&m_pModel);
+            generation = m_generation;
+         }
+
+         const Dataset<TData> examples = GetExamples();
+         std::shared_ptr<INetwork<TData>> pnetwork = psnapshot->Clone();
+         auto ptrainer = pnetwork->CreateTrainer(m_optimizer);
+         try {
+            ptrainer->Train(examples);
+         }
+         catch (const std::invalid_argument&) {
+            throw ref new InvalidArgumentException(); // e.g. too few examples for a linear classifier or a forest
+         }
+         catch (const std::runtime_error&) {
+            throw ref new FailureException();
+         }
+         const TData range = InputRange(examples);
+
+         // a network created meanwhile takes precedence over the trained copy of its predecessor,
+         // online updates made meanwhile are superseded
+         std::shared_ptr<const INetwork<TData>> ptrained = std::move(pnetwork);
+         std::lock_guard<std::mutex> publishLk(m_publishMut);
+         if (generation == m_generation) {
+            m_generation++;
+            m_inputRange = range;
+            std::atomic_store(&m_pModel, ptrained);
+            Serve(ptrained);
+         }
+      }
+      // Cross-validates the grid on the stored examples and publishes the best configuration trained on all of them
+      std::vector<ModelScore<TData>> SelectModel(const ModelGrid<TData>& grid)
+      {
+         std::lock_guard<std::mutex> trainLk(m_trainMut);
+         const Dataset<TData> examples = GetExamples();
+         ModelSelection<TData> selection;
+         try {
+            selection = Processing::SelectModel(grid, examples);
+         }
+         catch (const std::invalid_argument&) {
+            throw ref new InvalidArgumentException();
+         }
+         Publish(std::move(selection.pmodel));
+         return selection.scores;
+      }
+      // used from the next training on
+      void SetOptimizer(OptimizerType optimizer)
+      {
+         m_optimizer = optimizer;
+      }
+      // Switches classification to an int8 export of the current model, also after later trainings.
+      // Returns the output deviation from the floating-point model over the stored examples, and the model sizes.
+      QuantizationError<TData> Quantize()
+      {
+         const Dataset<TData> examples = GetExamples();
+         const TData range = InputRange(examples);
+
+         // under the lock, so that a model published meanwhile can't be replaced by the export of its predecessor
+         std::shared_ptr<const INetwork<TData>> pmodel, pquantized;
+         size_t floatBytes, quantizedBytes;
+         {
+            std::lock_guard<std::mutex> publishLk(m_publishMut);
+            pmodel = std::atomic_load(&m_pModel);
+            std::unique_ptr<QuantizedNetwork<TData>> pexport;
+            try {
+               pexport = Processing::Quantize(*pmodel, range);
+            }
+            catch (const std::invalid_argument&) {
+               throw ref new InvalidArgumentException();
+            }
+            floatBytes = pexport->GetFloatWeightBytes();
+            quantizedBytes = pexport->GetWeightBytes();
+            pquantized = std::move(pexport);
+            m_inputRange = range;
+            m_quantized = true;
+            std::atomic_store(&m_pServing, pquantized);
+         }
+         QuantizationError<TData> res = CompareOutputs(*pmodel, *pquantized, examples);
+         res.floatBytes = floatBytes;
+         res.quantizedBytes = quantizedBytes;
+         return res;
+      }
+      void Dequantize()
+      {
+         std::lock_guard<std::mutex> publishLk(m_publishMut);
+         m_quantized = false;
+         std::atomic_store(&m_pServing, std::atomic_load(&m_pModel));
       }
       void Classify(const Array<TData>^ data, WriteOnlyArray<TData>^ output)
       {
+         std::shared_ptr<const INetwork<TData>> pmodel = std::atomic_load(&m_pServing);
+         assert(data->Length == pmodel->GetInputCount());
+         assert(output->Length == pmodel->GetOutputCount());
+
+         std::vector<TData> norm(begin(data), end(data));
+         Dataset<TData>::Normalize(norm.data(), norm.size());
+
+         pmodel->ComputeOutputs(norm.data(), output->Data);
+      }
+      // Writes the floating-point model, even when classification is quantized
+      void Save(String^ path)
+      {
+         std::shared_ptr<const INetwork<TData>> pmodel = std::atomic_load(&m_pModel);
+         if (!pmodel || !CanSaveNetwork(*pmodel))
+            throw ref new InvalidArgumentException(); // before the file is truncated
+
+         std::ofstream out(path->Data(), std::ios::binary | std::ios::trunc);
+         try {
+            SaveNetwork(*pmodel, out, InputNormalization::PerExample);
+         }
+         catch (const std::invalid_argument&) {
+            throw ref new InvalidArgumentException();
+         }
+         catch (const std::runtime_error&) {
+            throw ref new FailureException();
+         }
+      }
+      // Replaces the model like CreateXXNetwork(), the stored examples are kept
+      void Load(String^ path)
+      {
+         std::shared_ptr<const INetwork<TData>> pmodel;
+         InputNormalization normalization;
+         try {
+            pmodel = LoadNetwork<TData>(path->Data(), &normalization);
+         }
+         catch (const std::invalid_argument&) {
+            throw ref new InvalidArgumentException();
+         }
+         catch (const std::runtime_error&) {
+            throw ref new FailureException();
+         }
+         if (normalization != InputNormalization::PerExample)
+            throw ref new InvalidArgumentException();
+         Publish(std::move(pmodel));
+      }
+      // Moves the stored examples, and those added later, to a scratch file at path that is deleted when the
+      // classifier goes away. For corpora that don't fit in memory; trainings in progress keep reading their snapshot.
+      void SpillExamples(String^ path)
+      {
+         std::shared_ptr<const INetwork<TData>> pmodel = std::atomic_load(&m_pModel);
+         if (!pmodel)
+            throw ref new InvalidArgumentException();
+
          std::lock_guard<std::mutex> lk(m_mut);
-         assert(data->Length == m_pNetwork->GetInputCount());
-         assert(output->Length == m_pNetwork->GetOutputCount());
+         if (m_examples.GetCount() == 0)
+            m_examples = Dataset<TData>(pmodel->GetInputCount(), pmodel->GetOutputCount());
+         try {
+            m_examples.SpillTo(path->Data());
+         }
+         catch (const std::runtime_error&) {
+            throw ref new FailureException();
+         }
+      }
+      // data is row-major [example][input], output receives [example][output]
+      void ClassifyBatch(const Array<TData>^ data, WriteOnlyArray<TData>^ output)
+      {
+         std::shared_ptr<const INetwork<TData>> pmodel = std::atomic_load(&m_pServing);
+         const size_t inN = pmodel->GetInputCount();
+         const size_t count = data->Length / inN;
+         if (data->Length % inN != 0 || output->Length != count * pmodel->GetOutputCount())
+            throw ref new InvalidArgumentException();
 
          std::vector<TData> norm(begin(data), end(data));
-         Normalize(&norm);
+         concurrency::parallel_for((size_t)0, count, [&norm, inN](size_t ex) {
+            Dataset<TData>::Normalize(norm.data() + ex * inN, inN);
+         });
 
-         auto pres = std::make_unique<TData[]>(m_pNetwork->GetOutputCount());
-         m_pNetwork->ComputeOutputs(norm.data(), output->Data);
+         pmodel->ComputeBatch(norm.data(), count, output->Data);
       }
 
    private:
-      static void Normalize(std::vector<TData> *data)
+      void Publish(std::shared_ptr<const INetwork<TData>> pmodel)
+      {
+         std::lock_guard<std::mutex> publishLk(m_publishMut);
+         m_generation++;
+         std::atomic_store(&m_pModel, pmodel);
+         Serve(pmodel);
+      }
+      // normalized copies are appended to the examples and returned
+      void StoreExample(const Array<TData>^ input, const Array<TData>^ output, OUT std::vector<TData> *pin, OUT std::vector<TData> *pout)
       {
-         TData mean = std::accumulate(data->begin(), data->end(), (TData)0.0);
-         mean /= data->size();
+         assert(input->Length == std::atomic_load(&m_pModel)->GetInputCount());
+         assert(output->Length == std::atomic_load(&m_pModel)->GetOutputCount());
 
-         std::vector<TData> temp(data->size());
-         concurrency::parallel_transform(data->begin(), data->end(), temp.begin(), [mean](TData val) { return val - mean; });
-         TData sd = std::inner_product(temp.begin(), temp.end(), temp.begin(), (TData)0.0);
-         sd = std::sqrt(sd / (temp.size() - 1));
-         
-         concurrency::parallel_transform(data->begin(), data->end(), data->begin(), [mean, sd](TData val) { return (val - mean) / sd; });
+         std::lock_guard<std::mutex> lk(m_mut);
+         if (m_examples.GetCount() == 0 && (input->Length != m_examples.GetInputCount() || output->Length != m_examples.GetOutputCount()))
+            m_examples = Dataset<TData>(input->Length, output->Length);
+         assert(input->Length == m_examples.GetInputCount() && output->Length == m_examples.GetOutputCount());
+         m_examples.Add(input->Data, output->Data);
+
+         const size_t ex = m_examples.GetCount() - 1;
+         pin->assign(m_examples.GetInput(ex), m_examples.GetInput(ex) + input->Length);
+         pout->assign(begin(output), end(output));
+      }
+      // called with m_publishMut held, quantizes with the cached calibration so that online updates don't rescan the examples
+      void Serve(const std::shared_ptr<const INetwork<TData>>& pmodel)
+      {
+         // forests and linear classifiers have no quantized form and are served as they are
+         const bool quantizable = dynamic_cast<const BPNetwork<TData> *>(pmodel.get()) || dynamic_cast<const CCNetwork<TData> *>(pmodel.get());
+         if (m_quantized && quantizable)
+            std::atomic_store(&m_pServing, std::shared_ptr<const INetwork<TData>>(Processing::Quantize(*pmodel, m_inputRange)));
+         else
+            std::atomic_store(&m_pServing, pmodel);
+      }
+      // shares the stored rows, cheap enough to take under the lock
+      Dataset<TData> GetExamples()
+      {
+         std::lock_guard<std::mutex> lk(m_mut);
+         return m_examples;
       }
    };
 
@@ -0,0 +1,278 @@
+/*
+*    Copyright 2017 Mikhail Vasilyev
+*
+*    Licensed under the Apache License, Version 2.0 (the "License");
+*    you may not use this file except in compliance with the License.
+*    You may obtain a copy of the License at
+*
+*        http://www.apache.org/licenses/LICENSE-2.0
+*
+*    Unless required by applicable law or agreed to in writing, software
+*    distributed under the License is distributed on an "AS IS" BASIS,
+*    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+*    See the License for the specific language governing permissions and
+*    limitations under the License.
+*/
+#pragma once
+#include <algorithm>
+#include <cmath>
+#include <type_traits>
+#include <cassert>
+#include <cstdint>
+#include "../simd/Simd.h"
+
+#if defined(PROCESSING_SSE2) && (defined(__AVX__) || defined(__SSSE3__))
+ #define PROCESSING_SSSE3
+ #include <tmmintrin.h>
+#endif
+
+namespace Processing
+{
+   template <typename TData>
+   inline Pack<TData> Sigmoid(Pack<TData> x)
+   {
+      typedef Pack<TData> TPack;
+      return TPack((TData)1.0) / (TPack((TData)1.0) + Exp(-x));
+   }
+
+   // p[i] = 1 / (1 + exp(-(p[i] + pbias[i])))
+   template <typename TData>
+   inline void AddBiasSigmoid(size_t n, const TData *pbias, TData *p)
+   {
+      typedef Pack<TData> TPack;
+      size_t i = 0;
+      for (; i + TPack::Width <= n; i += TPack::Width)
+         Sigmoid(TPack::Load(p + i) + TPack::Load(pbias + i)).Store(p + i);
+      for (; i < n; ++i)
+         p[i] = (TData)1.0 / ((TData)1.0 + std::exp(-(p[i] + pbias[i])));
+   }
+
+   /// <summary>
+   /// Dense row-major matrix products, C = alpha * op(A) * op(B) (+ C).
+   /// Rows of C are split into tasks once a call is large enough, each task walks the
+   /// shared operand in depth blocks so that its panel stays in cache.
+   /// </summary>
+   template <typename TData>
+   struct Gemm
+   {
+      static_assert(std::is_floating_point_v<TData>, "floating point type required");
+      typedef Pack<TData> P;
+
+      static constexpr size_t KC = 256;          // depth of one block in the dot-product form
+      static constexpr size_t KA = 64;           // depth of one block in the axpy forms
+      static constexpr size_t NC = 256;          // columns of one block in the axpy forms
+      static constexpr size_t TASK_WORK = 32768; // multiply-adds per task, smaller calls stay on the caller's thread
+
+      // C[m][n] = alpha * sum_k A[m][k] * B[n][k]; A is M x K, B is N x K (e.g. inputs times a weight matrix)
+      static void NT(size_t M, size_t N, size_t K, TData alpha, const TData *A, size_t lda, const TData *B, size_t ldb,
+                     TData *C, size_t ldc, bool accumulate)
+      {
+         ForRowBlocks(M, N * K, [=](size_t i0, size_t i1) {
+            if (!accumulate)
+               ZeroRows(C, ldc, i0, i1, N);
+
+            for (size_t k0 = 0; k0 < K; k0 += KC) {
+               const size_t kc = std::min(KC, K - k0);
+               size_t i = i0;
+               for (; i + 2 <= i1; i += 2) {
+                  const TData *pa0 = A + i * lda + k0, *pa1 = pa0 + lda;
+                  TData *pc0 = C + i * ldc, *pc1 = pc0 + ldc;
+                  size_t j = 0;
+                  for (; j + 2 <= N; j += 2) {
+                     TData d[4];
+                     Dot2x2(pa0, pa1, B + j * ldb + k0, B + (j + 1) * ldb + k0, kc, d);
+                     pc0[j] += alpha * d[0];
+                     pc0[j + 1] += alpha * d[1];
+                     pc1[j] += alpha * d[2];
+                     pc1[j + 1] += alpha * d[3];
+                  }
+                  for (; j < N; ++j) {
+                     pc0[j] += alpha * Dot(pa0, B + j * ldb + k0, kc);
+                     pc1[j] += alpha * Dot(pa1, B + j * ldb + k0, kc);
+                  }
+               }
+               for (; i < i1; ++i) {
+                  for (size_t j = 0; j < N; ++j)
+                     C[i * ldc + j] += alpha * Dot(A + i * lda + k0, B + j * ldb + k0, kc);
+               }
+            }
+         });
+      }
+      // C[m][n] = alpha * sum_k A[m][k] * B[k][n]; A is M x K, B is K x N (e.g. deltas propagated through weights)
+      static void NN(size_t M, size_t N, size_t K, TData alpha, const TData *A, size_t lda, const TData *B, size_t ldb,
+                     TData *C, size_t ldc, bool accumulate)
+      {
+         AxpyForm(M, N, K, alpha, A, lda, 1, B, ldb, C, ldc, accumulate);
+      }
+      // C[m][n] = alpha * sum_k A[k][m] * B[k][n]; A is K x M, B is K x N (e.g. weight gradients over a batch)
+      static void TN(size_t M, size_t N, size_t K, TData alpha, const TData *A, size_t lda, const TData *B, size_t ldb,
+                     TData *C, size_t ldc, bool accumulate)
+      {
+         AxpyForm(M, N, K, alpha, A, 1, lda, B, ldb, C, ldc, accumulate);
+      }
+      // y[m] = sigmoid(sum_k A[m][k] * x[k] + bias[m]); A is M x K (a layer of sigmoid units)
+      static void GemvSigmoid(size_t M, size_t K, const TData *A, size_t lda, const TData *x, const TData *pbias, TData *y)
+      {
+         ForRowBlocks(M, K, [=](size_t i0, size_t i1) {
+            size_t i = i0;
+            for (; i + 4 <= i1; i += 4)
+               Dot4(A + i * lda, lda, x, K, y + i);
+            for (; i < i1; ++i)
+               y[i] = Dot(A + i * lda, x, K);
+            AddBiasSigmoid(i1 - i0, pbias + i0, y + i0);
+         });
+      }
+      // y += a * x
+      static void Axpy(size_t n, TData a, const TData *x, TData *y)
+      {
+         const P pa(a);
+         size_t i = 0;
+         for (; i + P::Width <= n; i += P::Width)
+            (P::Load(y + i) + pa * P::Load(x + i)).Store(y + i);
+         for (; i < n; ++i)
+            y[i] += a * x[i];
+      }
+      static TData Dot(const TData *x, const TData *y, size_t n)
+      {
+         P acc0((TData)0.0), acc1((TData)0.0);
+         size_t i = 0;
+         for (; i + 2 * P::Width <= n; i += 2 * P::Width) {
+            acc0 = acc0 + P::Load(x + i) * P::Load(y + i);
+            acc1 = acc1 + P::Load(x + i + P::Width) * P::Load(y + i + P::Width);
+         }
+         TData res = (acc0 + acc1).Sum();
+         for (; i < n; ++i)
+            res += x[i] * y[i];
+         return res;
+      }
+
+   private:
+      // Runs f(i0, i1) over row ranges of roughly TASK_WORK multiply-adds each
+      template <typename F>
+      static void ForRowBlocks(size_t M, size_t rowWork, F&& f)
+      {
+         size_t rows = std::max<size_t>(2, TASK_WORK / std::max<size_t>(rowWork, 1));
+         rows += rows & 1; // keep 2-row micro-kernels whole
+         const size_t tasks = (M + rows - 1) / rows;
+         if (tasks <= 1) {
+            f((size_t)0, M);
+            return;
+         }
+         concurrency::parallel_for((size_t)0, tasks, [&f, rows, M](size_t task) {
+            f(task * rows, std::min(M, (task + 1) * rows));
+         });
+      }
+      static void ZeroRows(TData *C, size_t ldc, size_t i0, size_t i1, size_t N)
+      {
+         for (size_t i = i0; i < i1; ++i)
+            std::fill(C + i * ldc, C + i * ldc + N, (TData)0.0);
+      }
+      // 2 rows of A against 2 rows of B, d = { a0.b0, a0.b1, a1.b0, a1.b1 }
+      static void Dot2x2(const TData *pa0, const TData *pa1, const TData *pb0, const TData *pb1, size_t n, TData *d)
+      {
+         P c00((TData)0.0), c01((TData)0.0), c10((TData)0.0), c11((TData)0.0);
+         size_t k = 0;
+         for (; k + P::Width <= n; k += P::Width) {
+            P a0 = P::Load(pa0 + k), a1 = P::Load(pa1 + k);
+            P b0 = P::Load(pb0 + k), b1 = P::Load(pb1 + k);
+            c00 = c00 + a0 * b0;
+            c01 = c01 + a0 * b1;
+            c10 = c10 + a1 * b0;
+            c11 = c11 + a1 * b1;
+         }
+         d[0] = c00.Sum();
+         d[1] = c01.Sum();
+         d[2] = c10.Sum();
+         d[3] = c11.Sum();
+         for (; k < n; ++k) {
+            d[0] += pa0[k] * pb0[k];
+            d[1] += pa0[k] * pb1[k];
+            d[2] += pa1[k] * pb0[k];
+            d[3] += pa1[k] * pb1[k];
+         }
+      }
+      // 4 consecutive rows of A against x, sharing the loads of x
+      static void Dot4(const TData *pa, size_t lda, const TData *x, size_t n, TData *d)
+      {
+         P c0((TData)0.0), c1((TData)0.0), c2((TData)0.0), c3((TData)0.0);
+         size_t k = 0;
+         for (; k + P::Width <= n; k += P::Width) {
+            P xk = P::Load(x + k);
+            c0 = c0 + P::Load(pa + k) * xk;
+            c1 = c1 + P::Load(pa + lda + k) * xk;
+            c2 = c2 + P::Load(pa + 2 * lda + k) * xk;
+            c3 = c3 + P::Load(pa + 3 * lda + k) * xk;
+         }
+         d[0] = c0.Sum();
+         d[1] = c1.Sum();
+         d[2] = c2.Sum();
+         d[3] = c3.Sum();
+         for (; k < n; ++k) {
+            d[0] += pa[k] * x[k];
+            d[1] += pa[lda + k] * x[k];
+            d[2] += pa[2 * lda + k] * x[k];
+            d[3] += pa[3 * lda + k] * x[k];
+         }
+      }
+      // C[m][:] += alpha * A(m, k) * B[k][:], A(m, k) = A[m * ams + k * aks]
+      static void AxpyForm(size_t M, size_t N, size_t K, TData alpha, const TData *A, size_t ams, size_t aks,
+                           const TData *B, size_t ldb, TData *C, size_t ldc, bool accumulate)
+      {
+         ForRowBlocks(M, N * K, [=](size_t i0, size_t i1) {
+            if (!accumulate)
+               ZeroRows(C, ldc, i0, i1, N);
+
+            for (size_t k0 = 0; k0 < K; k0 += KA) {
+               const size_t k1 = std::min(K, k0 + KA);
+               for (size_t j0 = 0; j0 < N; j0 += NC) {
+                  const size_t nc = std::min(NC, N - j0);
+                  for (size_t i = i0; i < i1; ++i) {
+                     TData *pc = C + i * ldc + j0;
+                     for (size_t k = k0; k < k1; ++k) {
+                        TData a = alpha * A[i * ams + k * aks];
+                        if (a != (TData)0.0)
+                           Axpy(nc, a, B + k * ldb + j0, pc);
+                     }
+                  }
+               }
+            }
+         });
+      }
+   };
+
+   // sum a[i] * w[i] over 7-bit unsigned activations and signed 8-bit weights. Keeping activations
+   // below 128 means pmaddubsw pair sums cannot saturate, so every path gives the exact result.
+   inline int32_t DotU7S8(const uint8_t *a, const int8_t *w, size_t n)
+   {
+      size_t i = 0;
+      int32_t sum = 0;
+#if defined(PROCESSING_SSE2)
+      __m128i acc = _mm_setzero_si128();
+ #if defined(PROCESSING_SSSE3)
+      const __m128i ones = _mm_set1_epi16(1);
+      for (; i + 16 <= n; i += 16) {
+         __m128i pairs = _mm_maddubs_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i *>(a + i)),
+                                           _mm_loadu_si128(reinterpret_cast<const __m128i *>(w + i)));
+         acc = _mm_add_epi32(acc, _mm_madd_epi16(pairs, ones));
+      }
+ #else
+      const __m128i zero = _mm_setzero_si128();
+      for (; i + 16 <= n; i += 16) {
+         __m128i va = _mm_loadu_si128(reinterpret_cast<const __m128i *>(a + i));
+         __m128i vw = _mm_loadu_si128(reinterpret_cast<const __m128i *>(w + i));
+         // widen to 16 bits, weights by sign extension
+         __m128i wlo = _mm_srai_epi16(_mm_unpacklo_epi8(vw, vw), 8);
+         __m128i whi = _mm_srai_epi16(_mm_unpackhi_epi8(vw, vw), 8);
+         acc = _mm_add_epi32(acc, _mm_madd_epi16(_mm_unpacklo_epi8(va, zero), wlo));
+         acc = _mm_add_epi32(acc, _mm_madd_epi16(_mm_unpackhi_epi8(va, zero), whi));
+      }
+ #endif
+      acc = _mm_add_epi32(acc, _mm_shuffle_epi32(acc, _MM_SHUFFLE(1, 0, 3, 2)));
+      acc = _mm_add_epi32(acc, _mm_shuffle_epi32(acc, _MM_SHUFFLE(2, 3, 0, 1)));
+      sum = _mm_cvtsi128_si32(acc);
+#endif
+      for (; i < n; ++i)
+         sum += (int32_t)a[i] * w[i];
+      return sum;
+   }
+}
@@ -0,0 +1,284 @@
+/*
+*    Copyright 2017 Mikhail Vasilyev
+*
+*    Licensed under the Apache License, Version 2.0 (the "License");
+*    you may not use this file except in compliance with the License.
+*    You may obtain a copy of the License at
+*
+*        http://www.apache.org/licenses/LICENSE-2.0
+*
+*    Unless required by applicable law or agreed to in writing, software
+*    distributed under the License is distributed on an "AS IS" BASIS,
+*    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+*    See the License for the specific language governing permissions and
+*    limitations under the License.
+*/
+#pragma once
+#include <vector>
+#include <algorithm>
+#include <numeric>
+#include <random>
+#include <limits>
+#include <cmath>
+#include <cassert>
+#include <stdexcept>
+#include <type_traits>
+#include "LinearAlgebra.h"
+
+#ifndef OUT
+ #define OUT
+#endif
+
+namespace Processing
+{
+   enum class LinearOutput
+   {
+      Softmax, // scores are log-posteriors up to a constant, outputs sum to 1
+      Sigmoid  // scores are independent margins
+   };
+
+   /// <summary>
+   /// One linear score per output, scores = W * x + b, mapped to (0, 1) so that outputs
+   /// compare with those of the networks. The class is the largest output either way.
+   /// </summary>
+   template <typename TData>
+   class LinearModel final
+   {
+      static_assert(std::is_floating_point_v<TData>, "");
+      typedef Gemm<TData> G;
+
+      size_t m_inputCount, m_outputCount;
+      std::vector<TData> m_weights; // [output][input]
+      std::vector<TData> m_biases;  // [output]
+      LinearOutput m_mapping;
+
+   public:
+      LinearModel(size_t inputCount, size_t outputCount, LinearOutput mapping)
+         : m_inputCount(inputCount), m_outputCount(outputCount),
+         m_weights(inputCount * outputCount, (TData)0.0), m_biases(outputCount, (TData)0.0), m_mapping(mapping)
+      { }
+      size_t GetInputCount() const noexcept
+      {
+         return m_inputCount;
+      }
+      size_t GetOutputCount() const noexcept
+      {
+         return m_outputCount;
+      }
+      TData *GetWeights() noexcept
+      {
+         return m_weights.data();
+      }
+      TData *GetBiases() noexcept
+      {
+         return m_biases.data();
+      }
+      void Predict(const TData *pinput, OUT TData *poutput) const
+      {
+         for (size_t i = 0; i < m_outputCount; ++i)
+            poutput[i] = G::Dot(&m_weights[i * m_inputCount], pinput, m_inputCount);
+         Map(poutput);
+      }
+      // row-major [example][input] in and [example][output] out
+      void PredictBatch(const TData *pinputs, size_t count, OUT TData *poutputs) const
+      {
+         G::NT(count, m_outputCount, m_inputCount, (TData)1.0, pinputs, m_inputCount, m_weights.data(), m_inputCount,
+               poutputs, m_outputCount, false);
+         for (size_t ex = 0; ex < count; ++ex)
+            Map(poutputs + ex * m_outputCount);
+      }
+
+   private:
+      void Map(TData *pscores) const
+      {
+         for (size_t i = 0; i < m_outputCount; ++i)
+            pscores[i] += m_biases[i];
+
+         if (m_mapping == LinearOutput::Sigmoid) {
+            for (size_t i = 0; i < m_outputCount; ++i)
+               pscores[i] = (TData)1.0 / ((TData)1.0 + std::exp(-pscores[i]));
+            return;
+         }
+         const TData max = *std::max_element(pscores, pscores + m_outputCount);
+         TData sum = 0;
+         for (size_t i = 0; i < m_outputCount; ++i) {
+            pscores[i] = std::exp(pscores[i] - max);
+            sum += pscores[i];
+         }
+         for (size_t i = 0; i < m_outputCount; ++i)
+            pscores[i] /= sum;
+      }
+   };
+
+   // class of an example, the largest target output
+   template <typename TData>
+   inline size_t ClassOf(const TData *poutput, size_t outputCount)
+   {
+      return std::max_element(poutput, poutput + outputCount) - poutput;
+   }
+
+   /// <summary>
+   /// Linear discriminant analysis with the pooled within-class covariance shrunk towards a multiple of
+   /// the identity, by the Ledoit-Wolf estimate of the optimal amount. Closed form: one covariance pass
+   /// and one Cholesky factorization. pmodel should map its outputs with LinearOutput::Softmax.
+   /// Returns the shrinkage used, at least MIN_SHRINKAGE.
+   /// </summary>
+   template <typename TData>
+   inline TData FitShrinkageLda(const std::vector<const TData *>& inputs, const std::vector<const TData *>& outputs,
+                                OUT LinearModel<TData> *pmodel)
+   {
+      typedef Gemm<TData> G;
+      static constexpr size_t BLOCK = 256; // examples per covariance update
+      // Examples normalized per row (Dataset::Normalize) sum to zero, so the covariance is singular along
+      // the all-ones direction whatever n is, while the Ledoit-Wolf estimate tends to 0 as n grows
+      static constexpr TData MIN_SHRINKAGE = (TData)1e-3;
+
+      const size_t d = pmodel->GetInputCount(), K = pmodel->GetOutputCount(), n = inputs.size();
+      if (n < 2 || outputs.size() != n)
+         throw std::invalid_argument("too few examples");
+
+      std::vector<size_t> classes(n), counts(K, 0);
+      std::vector<TData> means(K * d, (TData)0.0); // [class][input]
+      for (size_t ex = 0; ex < n; ++ex) {
+         classes[ex] = ClassOf(outputs[ex], K);
+         counts[classes[ex]]++;
+         G::Axpy(d, (TData)1.0, inputs[ex], &means[classes[ex] * d]);
+      }
+      for (size_t k = 0; k < K; ++k) {
+         if (counts[k])
+            std::transform(&means[k * d], &means[k * d] + d, &means[k * d], [&](TData m) { return m / counts[k]; });
+      }
+
+      // S = Xc' * Xc / n over blocks of examples centered on their class means
+      std::vector<TData> cov(d * d, (TData)0.0), block(BLOCK * d);
+      TData fourthMoment = 0; // sum of |xc|^4, for the shrinkage estimate
+      for (size_t first = 0; first < n; first += BLOCK) {
+         const size_t rows = std::min(BLOCK, n - first);
+         for (size_t r = 0; r < rows; ++r) {
+            const TData *px = inputs[first + r], *pmean = &means[classes[first + r] * d];
+            TData *pc = &block[r * d];
+            for (size_t i = 0; i < d; ++i)
+               pc[i] = px[i] - pmean[i];
+            const TData sq = G::Dot(pc, pc, d);
+            fourthMoment += sq * sq;
+         }
+         G::TN(d, d, rows, (TData)1.0, block.data(), d, block.data(), d, cov.data(), d, true);
+      }
+      for (TData& c : cov)
+         c /= n;
+
+      // Ledoit & Wolf, "A well-conditioned estimator for large-dimensional covariance matrices", 2004
+      TData trace = 0;
+      for (size_t i = 0; i < d; ++i)
+         trace += cov[i * d + i];
+      const TData mu = trace / d;
+      const TData frobenius = G::Dot(cov.data(), cov.data(), d * d);
+      const TData delta = (frobenius - d * mu * mu) / d;
+      const TData beta = std::min(delta, (fourthMoment / n - frobenius) / (d * n));
+      const TData shrinkage = delta > 0 ? std::max(std::max(beta, (TData)0.0) / delta, MIN_SHRINKAGE) : (TData)1.0;
+      for (TData& c : cov)
+         c *= 1 - shrinkage;
+      for (size_t i = 0; i < d; ++i)
+         cov[i * d + i] += shrinkage * mu;
+
+      // Cholesky, cov = L * L' with L in the lower triangle
+      for (size_t j = 0; j < d; ++j) {
+         TData *prow = &cov[j * d];
+         const TData pivot = prow[j] - G::Dot(prow, prow, j);
+         if (!(pivot > 0))
+            throw std::invalid_argument("examples without variance");
+         prow[j] = std::sqrt(pivot);
+         for (size_t i = j + 1; i < d; ++i)
+            cov[i * d + j] = (cov[i * d + j] - G::Dot(&cov[i * d], prow, j)) / prow[j];
+      }
+
+      // w_k = cov^-1 * mean_k, b_k = -mean_k' * w_k / 2 + log(prior_k)
+      for (size_t k = 0; k < K; ++k) {
+         TData *pw = pmodel->GetWeights() + k * d;
+         if (!counts[k]) {
+            std::fill(pw, pw + d, (TData)0.0);
+            pmodel->GetBiases()[k] = -std::numeric_limits<TData>::infinity();
+            continue;
+         }
+         const TData *pmean = &means[k * d];
+         for (size_t i = 0; i < d; ++i)
+            pw[i] = (pmean[i] - G::Dot(&cov[i * d], pw, i)) / cov[i * d + i];
+         for (size_t i = d; i-- > 0;) {
+            TData sum = pw[i];
+            for (size_t j = i + 1; j < d; ++j)
+               sum -= cov[j * d + i] * pw[j];
+            pw[i] = sum / cov[i * d + i];
+         }
+         pmodel->GetBiases()[k] = -G::Dot(pmean, pw, d) / 2 + std::log((TData)counts[k] / n);
+      }
+      return shrinkage;
+   }
+
+   /// <summary>
+   /// One-vs-rest linear SVMs with hinge loss, each solved by dual coordinate descent (Hsieh et al.,
+   /// "A dual coordinate descent method for large-scale linear SVM", 2008). The bias is learned as the
+   /// weight of a constant input. Outputs are concurrently trained, pmodel should map with LinearOutput::Sigmoid.
+   /// Returns the largest number of passes over the examples any output needed.
+   /// </summary>
+   template <typename TData>
+   inline size_t FitLinearSvm(const std::vector<const TData *>& inputs, const std::vector<const TData *>& outputs, TData cost,
+                              OUT LinearModel<TData> *pmodel, size_t maxEpochs = 1000, TData tolerance = (TData)0.1, uint32_t seed = 0)
+   {
+      typedef Gemm<TData> G;
+
+      const size_t d = pmodel->GetInputCount(), K = pmodel->GetOutputCount(), n = inputs.size();
+      if (n == 0 || outputs.size() != n || !(cost > 0))
+         throw std::invalid_argument("no examples or no positive cost");
+
+      std::vector<TData> diag(n); // Q_ii of the dual, bias input included
+      std::vector<size_t> classes(n);
+      for (size_t ex = 0; ex < n; ++ex) {
+         diag[ex] = G::Dot(inputs[ex], inputs[ex], d) + 1;
+         classes[ex] = ClassOf(outputs[ex], K);
+      }
+
+      std::vector<size_t> epochs(K);
+      concurrency::parallel_for((size_t)0, K, [&](size_t k) {
+         TData *pw = pmodel->GetWeights() + k * d;
+         TData bias = 0;
+         std::fill(pw, pw + d, (TData)0.0);
+         std::vector<TData> alpha(n, (TData)0.0);
+         std::vector<size_t> order(n);
+         std::iota(order.begin(), order.end(), 0);
+         std::mt19937 engine(seed + (uint32_t)k);
+
+         size_t epoch = 0;
+         while (epoch < maxEpochs) {
+            epoch++;
+            std::shuffle(order.begin(), order.end(), engine);
+            TData maxPG = -std::numeric_limits<TData>::infinity(), minPG = std::numeric_limits<TData>::infinity();
+            for (size_t ex : order) {
+               const TData y = classes[ex] == k ? (TData)1.0 : (TData)-1.0;
+               const TData grad = y * (G::Dot(pw, inputs[ex], d) + bias) - 1;
+
+               // projected gradient, zero where the box constraint 0 <= alpha <= cost holds it
+               TData projected = grad;
+               if (alpha[ex] == 0)
+                  projected = std::min(grad, (TData)0.0);
+               else if (alpha[ex] == cost)
+                  projected = std::max(grad, (TData)0.0);
+               maxPG = std::max(maxPG, projected);
+               minPG = std::min(minPG, projected);
+               if (projected == 0)
+                  continue;
+
+               const TData prev = alpha[ex];
+               alpha[ex] = std::min(std::max(prev - grad / diag[ex], (TData)0.0), cost);
+               const TData step = (alpha[ex] - prev) * y;
+               G::Axpy(d, step, inputs[ex], pw);
+               bias += step;
+            }
+            if (maxPG - minPG < tolerance)
+               break;
+         }
+         pmodel->GetBiases()[k] = bias;
+         epochs[k] = epoch;
+      });
+      return *std::max_element(epochs.cbegin(), epochs.cend());
+   }
+}
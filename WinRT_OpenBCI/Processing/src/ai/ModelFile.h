@@ -0,0 +1,196 @@
+/*
+*    Copyright 2017 Mikhail Vasilyev
+*
+*    Licensed under the Apache License, Version 2.0 (the "License");
+*    you may not use this file except in compliance with the License.
+*    You may obtain a copy of the License at
+*
+*        http://www.apache.org/licenses/LICENSE-2.0
+*
+*    Unless required by applicable law or agreed to in writing, software
+*    distributed under the License is distributed on an "AS IS" BASIS,
+*    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+*    See the License for the specific language governing permissions and
+*    limitations under the License.
+*/
+#pragma once
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <ostream>
+#include <stdexcept>
+
+#ifdef _WIN32
+ #ifndef WIN32_LEAN_AND_MEAN
+  #define WIN32_LEAN_AND_MEAN
+ #endif
+ #ifndef NOMINMAX
+  #define NOMINMAX // the min and max macros would break std::min and std::max in the headers including this one
+ #endif
+ #include <windows.h>
+#else
+ #include <sys/mman.h>
+ #include <sys/stat.h>
+ #include <fcntl.h>
+ #include <unistd.h>
+#endif
+
+namespace Processing
+{
+   enum class ModelType : uint32_t
+   {
+      BackPropagation = 1,
+      CascadeCorrelation = 2
+   };
+
+   // How inputs must be prepared before they are fed to a stored network
+   enum class InputNormalization : uint32_t
+   {
+      None = 0,
+      PerExample = 1 // zero mean and unit standard deviation within each example, as Classifier does
+   };
+
+   // Fixed 64-byte header of a model file. It is followed by the payload at payloadOffset; every array
+   // in the payload starts on a MODEL_ALIGNMENT boundary, so a mapped file can be used in place.
+   struct ModelFileHeader
+   {
+      static constexpr uint32_t MAGIC = 0x4C444D52; // "RMDL"
+      static constexpr uint32_t VERSION = 1;
+
+      uint32_t magic;
+      uint32_t version;
+      ModelType type;
+      uint32_t scalarSize;   // sizeof the stored weights, 4 or 8
+      uint32_t inputCount;
+      uint32_t outputCount;
+      uint32_t layerSize;    // BackPropagation: nodes per hidden layer; CascadeCorrelation: hidden unit count
+      uint32_t layerCount;   // BackPropagation: layers including the output layer
+      InputNormalization normalization;
+      uint32_t reserved0;
+      uint64_t payloadOffset;
+      uint64_t payloadSize;
+      uint8_t reserved[8];
+   };
+   static_assert(sizeof(ModelFileHeader) == 64, "model file header must stay 64 bytes");
+
+   constexpr size_t MODEL_ALIGNMENT = 64;
+
+   // Elements of TData needed to keep count values followed by padding up to the next boundary
+   template <typename TData>
+   constexpr size_t AlignedCount(size_t count)
+   {
+      constexpr size_t step = MODEL_ALIGNMENT / sizeof(TData);
+      return (count + step - 1) / step * step;
+   }
+
+   inline void WriteModel(std::ostream& out, const ModelFileHeader& header, const void *ppayload)
+   {
+      static const char zeros[MODEL_ALIGNMENT] = {};
+      out.write(reinterpret_cast<const char *>(&header), sizeof(header));
+      out.write(zeros, header.payloadOffset - sizeof(header));
+      out.write(reinterpret_cast<const char *>(ppayload), header.payloadSize);
+      if (!out)
+         throw std::runtime_error("failed to write the model");
+   }
+
+   /// <summary>
+   /// Read-only view of a whole file, mapped copy-on-write so that pages are loaded on demand
+   /// and writes through the view never reach the file.
+   /// </summary>
+   class MappedFile final
+   {
+#ifdef _WIN32
+      HANDLE m_file = INVALID_HANDLE_VALUE;
+      HANDLE m_mapping = nullptr;
+#else
+      int m_fd = -1;
+#endif
+      void *m_pview = nullptr;
+      size_t m_size = 0;
+
+   public:
+#ifdef _WIN32
+      typedef wchar_t PathChar;
+#else
+      typedef char PathChar;
+#endif
+
+      explicit MappedFile(const PathChar *path)
+      {
+#ifdef _WIN32
+         m_file = CreateFile2(path, GENERIC_READ, FILE_SHARE_READ, OPEN_EXISTING, nullptr);
+         LARGE_INTEGER size;
+         if (m_file == INVALID_HANDLE_VALUE || !GetFileSizeEx(m_file, &size))
+            Fail("cannot open the model file");
+         m_size = (size_t)size.QuadPart;
+         m_mapping = CreateFileMappingFromApp(m_file, nullptr, PAGE_WRITECOPY, 0, nullptr);
+         if (m_mapping)
+            m_pview = MapViewOfFileFromApp(m_mapping, FILE_MAP_COPY, 0, 0);
+#else
+         struct stat st;
+         m_fd = open(path, O_RDONLY);
+         if (m_fd < 0 || fstat(m_fd, &st) != 0)
+            Fail("cannot open the model file");
+         m_size = (size_t)st.st_size;
+         m_pview = m_size ? mmap(nullptr, m_size, PROT_READ | PROT_WRITE, MAP_PRIVATE, m_fd, 0) : nullptr;
+         if (m_pview == MAP_FAILED)
+            m_pview = nullptr;
+#endif
+         if (!m_pview)
+            Fail("cannot map the model file");
+      }
+      MappedFile(const MappedFile&) = delete;
+      MappedFile& operator =(const MappedFile&) = delete;
+      ~MappedFile()
+      {
+         Release();
+      }
+      const uint8_t *GetData() const noexcept
+      {
+         return static_cast<const uint8_t *>(m_pview);
+      }
+      size_t GetSize() const noexcept
+      {
+         return m_size;
+      }
+      // Validated header, payload bounds included
+      const ModelFileHeader& GetModelHeader() const
+      {
+         if (m_size < sizeof(ModelFileHeader))
+            throw std::invalid_argument("not a model file");
+         const ModelFileHeader& header = *reinterpret_cast<const ModelFileHeader *>(m_pview);
+         if (header.magic != ModelFileHeader::MAGIC || header.version != ModelFileHeader::VERSION)
+            throw std::invalid_argument("not a model file or unsupported version");
+         if (header.payloadOffset % MODEL_ALIGNMENT != 0 || header.payloadOffset > m_size || header.payloadSize > m_size - header.payloadOffset)
+            throw std::invalid_argument("truncated model file");
+         return header;
+      }
+      const uint8_t *GetPayload() const
+      {
+         return GetData() + GetModelHeader().payloadOffset;
+      }
+
+   private:
+      void Release() noexcept
+      {
+#ifdef _WIN32
+         if (m_pview)
+            UnmapViewOfFile(m_pview);
+         if (m_mapping)
+            CloseHandle(m_mapping);
+         if (m_file != INVALID_HANDLE_VALUE)
+            CloseHandle(m_file);
+#else
+         if (m_pview)
+            munmap(m_pview, m_size);
+         if (m_fd >= 0)
+            close(m_fd);
+#endif
+      }
+      [[noreturn]] void Fail(const char *message)
+      {
+         Release();
+         throw std::runtime_error(message);
+      }
+   };
+}
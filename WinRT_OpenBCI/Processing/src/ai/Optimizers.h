@@ -0,0 +1,205 @@
+/*
+*    Copyright 2017 Mikhail Vasilyev
+*
+*    Licensed under the Apache License, Version 2.0 (the "License");
+*    you may not use this file except in compliance with the License.
+*    You may obtain a copy of the License at
+*
+*        http://www.apache.org/licenses/LICENSE-2.0
+*
+*    Unless required by applicable law or agreed to in writing, software
+*    distributed under the License is distributed on an "AS IS" BASIS,
+*    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+*    See the License for the specific language governing permissions and
+*    limitations under the License.
+*/
+#pragma once
+#include <vector>
+#include <memory>
+#include <algorithm>
+#include <cmath>
+#include <cassert>
+#include <type_traits>
+
+namespace Processing
+{
+   enum class OptimizerType
+   {
+      GradientDescent,
+      Rprop,
+      Quickprop,
+      Adam
+   };
+
+   /// <summary>
+   /// Update rule for a block of parameters. Per-parameter state is kept in arrays
+   /// indexed like the parameters, so every step is a few linear passes.
+   /// </summary>
+   template <typename TData>
+   class IOptimizer
+   {
+      static_assert(std::is_floating_point_v<TData>, "");
+
+   public:
+      virtual ~IOptimizer() { }
+      // RPROP and Quickprop need the gradient of the whole training set, one step per epoch
+      virtual bool IsFullBatch() const noexcept = 0;
+      // pgrads holds dE/dw summed over exampleCount examples; rate comes from the trainer's schedule
+      virtual void Step(TData *pparams, const TData *pgrads, size_t exampleCount, TData rate) = 0;
+   };
+
+   // w -= rate * grad, as the trainers have always done
+   template <typename TData>
+   class GradientDescent final : public IOptimizer<TData>
+   {
+      const size_t m_count;
+
+   public:
+      explicit GradientDescent(size_t count) : m_count(count)
+      { }
+      virtual bool IsFullBatch() const noexcept
+      {
+         return false;
+      }
+      virtual void Step(TData *pparams, const TData *pgrads, size_t exampleCount, TData rate)
+      {
+         for (size_t i = 0; i < m_count; ++i)
+            pparams[i] -= rate * pgrads[i];
+      }
+   };
+
+   // iRprop-, Igel & Huesken 2000: only the sign of the gradient is used, step sizes adapt per weight
+   template <typename TData>
+   class Rprop final : public IOptimizer<TData>
+   {
+      static constexpr TData ETA_PLUS = (TData)1.2, ETA_MINUS = (TData)0.5;
+      static constexpr TData STEP_MIN = (TData)1e-6, STEP_MAX = (TData)50.0, STEP_INIT = (TData)0.1;
+
+      const size_t m_count;
+      std::vector<TData> m_steps;     // [param]
+      std::vector<TData> m_prevGrads; // [param]
+
+   public:
+      explicit Rprop(size_t count) : m_count(count), m_steps(count, STEP_INIT), m_prevGrads(count, (TData)0.0)
+      { }
+      virtual bool IsFullBatch() const noexcept
+      {
+         return true;
+      }
+      virtual void Step(TData *pparams, const TData *pgrads, size_t exampleCount, TData rate)
+      {
+         TData *psteps = m_steps.data(), *pprev = m_prevGrads.data();
+         for (size_t i = 0; i < m_count; ++i) {
+            TData grad = pgrads[i];
+            TData product = grad * pprev[i];
+            if (product > 0) {
+               psteps[i] = std::min(psteps[i] * ETA_PLUS, STEP_MAX);
+            }
+            else if (product < 0) {
+               psteps[i] = std::max(psteps[i] * ETA_MINUS, STEP_MIN);
+               grad = 0; // no step, and no sign change seen next time
+            }
+            pparams[i] -= grad > 0 ? psteps[i] : (grad < 0 ? -psteps[i] : (TData)0.0);
+            pprev[i] = grad;
+         }
+      }
+   };
+
+   // Fahlman 1988: each weight jumps to the minimum of a parabola through its last two slopes
+   template <typename TData>
+   class Quickprop final : public IOptimizer<TData>
+   {
+      static constexpr TData MAX_GROWTH = (TData)1.75;
+
+      const size_t m_count;
+      std::vector<TData> m_prevSteps; // [param]
+      std::vector<TData> m_prevGrads; // [param]
+
+   public:
+      explicit Quickprop(size_t count) : m_count(count), m_prevSteps(count, (TData)0.0), m_prevGrads(count, (TData)0.0)
+      { }
+      virtual bool IsFullBatch() const noexcept
+      {
+         return true;
+      }
+      // rate scales the gradient term, which starts the descent and is kept while the slope doesn't change sign
+      virtual void Step(TData *pparams, const TData *pgrads, size_t exampleCount, TData rate)
+      {
+         const TData shrink = MAX_GROWTH / (1 + MAX_GROWTH);
+         const TData scale = (TData)1.0 / std::max<size_t>(exampleCount, 1);
+         TData *psteps = m_prevSteps.data(), *pprev = m_prevGrads.data();
+         for (size_t i = 0; i < m_count; ++i) {
+            const TData grad = pgrads[i] * scale, prevGrad = pprev[i], prevStep = psteps[i];
+            TData step = 0;
+            if (prevStep == 0) {
+               step = -rate * grad;
+            }
+            else {
+               // slopes along the previous step, positive while the error still decreases
+               const TData slope = prevStep > 0 ? -grad : grad, prevSlope = prevStep > 0 ? -prevGrad : prevGrad;
+               if (slope > 0)
+                  step -= rate * grad;
+               if (slope > shrink * prevSlope)
+                  step += MAX_GROWTH * prevStep; // parabola minimum too far or behind, grow the step instead
+               else if (prevGrad != grad)
+                  step += grad / (prevGrad - grad) * prevStep;
+            }
+            pparams[i] += step;
+            psteps[i] = step;
+            pprev[i] = grad;
+         }
+      }
+   };
+
+   // Kingma & Ba 2015, on the mean gradient of each batch; the step size is fixed, the trainer's rate is not used
+   template <typename TData>
+   class Adam final : public IOptimizer<TData>
+   {
+      static constexpr TData BETA1 = (TData)0.9, BETA2 = (TData)0.999, EPSILON = (TData)1e-8;
+
+      const size_t m_count;
+      const TData m_stepSize;
+      std::vector<TData> m_moments1; // [param]
+      std::vector<TData> m_moments2; // [param]
+      TData m_beta1Power, m_beta2Power;
+
+   public:
+      explicit Adam(size_t count, TData stepSize = (TData)0.01) : m_count(count), m_stepSize(stepSize),
+         m_moments1(count, (TData)0.0), m_moments2(count, (TData)0.0), m_beta1Power(1), m_beta2Power(1)
+      { }
+      virtual bool IsFullBatch() const noexcept
+      {
+         return false;
+      }
+      virtual void Step(TData *pparams, const TData *pgrads, size_t exampleCount, TData rate)
+      {
+         m_beta1Power *= BETA1;
+         m_beta2Power *= BETA2;
+         const TData scale = (TData)1.0 / std::max<size_t>(exampleCount, 1);
+         const TData stepSize = m_stepSize * std::sqrt(1 - m_beta2Power) / (1 - m_beta1Power);
+
+         TData *pm = m_moments1.data(), *pv = m_moments2.data();
+         for (size_t i = 0; i < m_count; ++i) {
+            const TData grad = pgrads[i] * scale;
+            pm[i] = BETA1 * pm[i] + (1 - BETA1) * grad;
+            pv[i] = BETA2 * pv[i] + (1 - BETA2) * grad * grad;
+            pparams[i] -= stepSize * pm[i] / (std::sqrt(pv[i]) + EPSILON);
+         }
+      }
+   };
+
+   template <typename TData>
+   inline std::unique_ptr<IOptimizer<TData>> CreateOptimizer(OptimizerType type, size_t count)
+   {
+      switch (type) {
+      case OptimizerType::Rprop:
+         return std::make_unique<Rprop<TData>>(count);
+      case OptimizerType::Quickprop:
+         return std::make_unique<Quickprop<TData>>(count);
+      case OptimizerType::Adam:
+         return std::make_unique<Adam<TData>>(count);
+      default:
+         return std::make_unique<GradientDescent<TData>>(count);
+      }
+   }
+}
@@ -22,6 +22,7 @@
 #include <memory>
 #include <type_traits>
 #include "IImfDecomposition.h"
+#include "Wavelet.h"
 
 using namespace Platform;
 using namespace Platform::Collections;
@@ -602,6 +603,38 @@ namespace Processing
       }
    };
 
+   template <typename TData, REQUIRES_FLOAT(TData)>
+   private ref class WaveletDecomposer : public DecomposerBase
+   {
+   internal:
+      // levelCount <= 0 or above the maximum selects the deepest level the data allows
+      WaveletDecomposer(const Array<TData>^ yValues, WaveletFamily family, int levelCount)
+         : DecomposerBase()
+      {
+         const int length = yValues->Length;
+         GetImfs<TData>() = ref new Vector<IVector<TData>^>();
+         GetResidue<TData>() = ref new Array<TData>(length);
+         std::copy(yValues->begin(), yValues->end(), GetResidue<TData>()->begin());
+
+         WaveletTransform<TData> transform(family);
+         const int maxLevel = transform.GetMaxLevel(length);
+         if (levelCount <= 0 || levelCount > maxLevel)
+            levelCount = maxLevel;
+         if (levelCount == 0)
+            return;
+
+         std::vector<TData> components((size_t)(levelCount + 1) * length);
+         transform.MultiResolution(yValues->Data, length, levelCount, components.data());
+
+         // details from high to low frequency play the role of IMFs, the approximation is the residue
+         for (int level = 0; level < levelCount; ++level) {
+            const TData *pbegin = components.data() + (size_t)level * length;
+            GetImfs<TData>()->Append(ref new Vector<TData>(std::vector<TData>(pbegin, pbegin + length)));
+         }
+         std::copy(components.end() - length, components.end(), GetResidue<TData>()->begin());
+      }
+   };
+
 #pragma endregion
 
 }
\ No newline at end of file
@@ -90,3 +90,33 @@ inline IAsyncOperation<Double::IImfDecomposition^>^ Emd::EnsembleDecomposeAsync(
    return Emd::EnsembleDecomposeAsync(xValues, yValues, 1.0f);
 }
 
+//-------------------------------------------------------------------------------------------------------------------------------------------------
+//-------------------------------------------------------------------------------------------------------------------------------------------------
+
+IAsyncOperation<Single::IImfDecomposition^>^ Emd::WaveletDecomposeAsync(const Array<float>^ yValues, WaveletFamily family, int levelCount)
+{
+   return concurrency::create_async([=]() {
+      return static_cast<Single::IImfDecomposition^>(ref new WaveletDecomposer<float>(yValues, family, levelCount));
+   });
+}
+
+inline IAsyncOperation<Single::IImfDecomposition^>^ Emd::WaveletDecomposeAsync(const Array<float>^ yValues, WaveletFamily family)
+{
+   return Emd::WaveletDecomposeAsync(yValues, family, 0);
+}
+
+//-------------------------------------------------------------------------------------------------------------------------------------------------
+
+[Windows::Foundation::Metadata::DefaultOverloadAttribute()]
+IAsyncOperation<Double::IImfDecomposition^>^ Emd::WaveletDecomposeAsync(const Array<double>^ yValues, WaveletFamily family, int levelCount)
+{
+   return concurrency::create_async([=]() {
+      return static_cast<Double::IImfDecomposition^>(ref new WaveletDecomposer<double>(yValues, family, levelCount));
+   });
+}
+
+[Windows::Foundation::Metadata::DefaultOverloadAttribute()]
+inline IAsyncOperation<Double::IImfDecomposition^>^ Emd::WaveletDecomposeAsync(const Array<double>^ yValues, WaveletFamily family)
+{
+   return Emd::WaveletDecomposeAsync(yValues, family, 0);
+}
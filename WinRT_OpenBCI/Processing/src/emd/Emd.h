@@ -15,6 +15,7 @@
 */
 #pragma once
 #include "IImfDecomposition.h"
+#include "WaveletFamily.h"
 
 using namespace Windows::Foundation;
 using namespace Platform;
@@ -115,5 +116,38 @@ namespace Processing
       /// <param name="yValues">Data y-axis</param>
       /// <returns>Max log2(length) intrinsic mode functions, no residue</returns>
       static IAsyncOperation<Double::IImfDecomposition^>^ EnsembleDecomposeAsync(const Array<double>^ xValues, const Array<double>^ yValues);
+
+
+      /// <summary>
+      /// Single-precision asynchronous discrete wavelet decomposition, an O(N) alternative to sifting
+      /// </summary>
+      /// <param name="yValues">Equally spaced data</param>
+      /// <param name="family">Wavelet to use</param>
+      /// <param name="levelCount">Number of detail components. 0 selects the deepest level the data length allows</param>
+      /// <returns>Band-limited components from high to low frequency in place of IMFs, and the coarsest approximation as residue</returns>
+      static IAsyncOperation<Single::IImfDecomposition^>^ WaveletDecomposeAsync(const Array<float>^ yValues, WaveletFamily family, int levelCount);
+      /// <summary>
+      /// Single-precision asynchronous discrete wavelet decomposition to the deepest level the data length allows
+      /// </summary>
+      /// <param name="yValues">Equally spaced data</param>
+      /// <param name="family">Wavelet to use</param>
+      /// <returns>Band-limited components from high to low frequency in place of IMFs, and the coarsest approximation as residue</returns>
+      static IAsyncOperation<Single::IImfDecomposition^>^ WaveletDecomposeAsync(const Array<float>^ yValues, WaveletFamily family);
+
+      /// <summary>
+      /// Double-precision asynchronous discrete wavelet decomposition, an O(N) alternative to sifting
+      /// </summary>
+      /// <param name="yValues">Equally spaced data</param>
+      /// <param name="family">Wavelet to use</param>
+      /// <param name="levelCount">Number of detail components. 0 selects the deepest level the data length allows</param>
+      /// <returns>Band-limited components from high to low frequency in place of IMFs, and the coarsest approximation as residue</returns>
+      static IAsyncOperation<Double::IImfDecomposition^>^ WaveletDecomposeAsync(const Array<double>^ yValues, WaveletFamily family, int levelCount);
+      /// <summary>
+      /// Double-precision asynchronous discrete wavelet decomposition to the deepest level the data length allows
+      /// </summary>
+      /// <param name="yValues">Equally spaced data</param>
+      /// <param name="family">Wavelet to use</param>
+      /// <returns>Band-limited components from high to low frequency in place of IMFs, and the coarsest approximation as residue</returns>
+      static IAsyncOperation<Double::IImfDecomposition^>^ WaveletDecomposeAsync(const Array<double>^ yValues, WaveletFamily family);
    };
 }
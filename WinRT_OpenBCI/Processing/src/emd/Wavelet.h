@@ -0,0 +1,186 @@
+/*
+*    Copyright 2017 Mikhail Vasilyev
+*
+*    Licensed under the Apache License, Version 2.0 (the "License");
+*    you may not use this file except in compliance with the License.
+*    You may obtain a copy of the License at
+*
+*        http://www.apache.org/licenses/LICENSE-2.0
+*
+*    Unless required by applicable law or agreed to in writing, software
+*    distributed under the License is distributed on an "AS IS" BASIS,
+*    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+*    See the License for the specific language governing permissions and
+*    limitations under the License.
+*/
+#pragma once
+#include <vector>
+#include <cmath>
+#include <cassert>
+#include <algorithm>
+#include <type_traits>
+#include "../simd/Simd.h"
+#include "WaveletFamily.h"
+
+namespace Processing
+{
+   /// <summary>
+   /// Multilevel orthogonal DWT with periodic extension, computed in polyphase form so that every
+   /// filter tap is a contiguous vector load. MultiResolution() turns the coefficients back into
+   /// full-length band-limited components which sum to the input, the way IMFs and residue do.
+   /// </summary>
+   template <typename TData, typename = std::enable_if_t<std::is_floating_point_v<TData>>>
+   class WaveletTransform final
+   {
+      typedef Pack<TData> P;
+
+      std::vector<TData> m_lo; // scaling filter, a[k] = sum(j) lo[j] * x[2k + j]
+      std::vector<TData> m_hi; // wavelet filter, hi[j] = (-1)^j * lo[L-1-j]
+
+   public:
+      explicit WaveletTransform(WaveletFamily family)
+      {
+         static const double haar[] = { 0.70710678118654752, 0.70710678118654752 };
+         static const double db2[] = { 0.48296291314453416, 0.83651630373780794, 0.22414386804201339, -0.12940952255126037 };
+         static const double db4[] = { 0.23037781330889650, 0.71484657055291565, 0.63088076792985890, -0.02798376941685985,
+                                       -0.18703481171909309, 0.03084138183556076, 0.03288301166688520, -0.01059740178506903 };
+         static const double sym4[] = { 0.03222310060404270, -0.01260396726203783, -0.09921954357684722, 0.29785779560527736,
+                                        0.80373875180591614, 0.49761866763201545, -0.02963552764599851, -0.07576571478927333 };
+         const double *pcoefs;
+         int length;
+         switch (family) {
+         case WaveletFamily::Haar:        pcoefs = haar; length = 2; break;
+         case WaveletFamily::Daubechies2: pcoefs = db2;  length = 4; break;
+         case WaveletFamily::Daubechies4: pcoefs = db4;  length = 8; break;
+         default:                         pcoefs = sym4; length = 8; break;
+         }
+         m_lo.assign(pcoefs, pcoefs + length);
+         m_hi.resize(length);
+         for (int j = 0; j < length; ++j)
+            m_hi[j] = (j % 2 ? -1 : 1) * m_lo[length - 1 - j];
+      }
+      int GetFilterLength() const noexcept
+      {
+         return (int)m_lo.size();
+      }
+      // Deepest level at which the filter still fits into the coarsest approximation
+      int GetMaxLevel(int length) const noexcept
+      {
+         int level = 0;
+         while ((length >> (level + 1)) >= GetFilterLength() - 1 && level < 30)
+            level++;
+         return level;
+      }
+      // Writes levels + 1 components of length samples to pcomponents, row-major:
+      // details from the finest scale to the coarsest, then the last approximation.
+      // The signal is extended symmetrically to a multiple of 2^levels, so any length works.
+      void MultiResolution(const TData *psignal, int length, int levels, TData *pcomponents) const
+      {
+         assert(levels > 0 && length > 1);
+         const int block = 1 << levels;
+         const int padded = (length + block - 1) / block * block;
+
+         std::vector<TData> x(padded);
+         std::copy(psignal, psignal + length, x.begin());
+         for (int i = length; i < padded; ++i) {
+            int mirrored = 2 * (length - 1) - i; // reflect about the last sample
+            x[i] = psignal[std::max(mirrored, 0) % length];
+         }
+
+         // analysis: coefficient bands, band j has padded >> (j + 1) values
+         std::vector<std::vector<TData>> details(levels);
+         std::vector<TData> approx(std::move(x));
+         for (int j = 0; j < levels; ++j) {
+            const int half = (int)approx.size() / 2;
+            std::vector<TData> a(half), d(half);
+            Analyse(approx.data(), half, a.data(), d.data());
+            details[j] = std::move(d);
+            approx = std::move(a);
+         }
+
+         // synthesis of each band on its own, from its level back up to full resolution
+         std::vector<TData> zeros(padded / 2, (TData)0.0);
+         for (int c = 0; c <= levels; ++c) {
+            const int level = std::min(c, levels - 1);
+            const int half = padded >> (level + 1);
+            std::vector<TData> cur(2 * half);
+            if (c < levels)
+               Synthesize(zeros.data(), details[c].data(), half, cur.data());
+            else
+               Synthesize(approx.data(), zeros.data(), half, cur.data());
+
+            for (int j = level - 1; j >= 0; --j) {
+               std::vector<TData> next(cur.size() * 2);
+               Synthesize(cur.data(), zeros.data(), (int)cur.size(), next.data());
+               cur = std::move(next);
+            }
+            std::copy(cur.begin(), cur.begin() + length, pcomponents + (size_t)c * length);
+         }
+      }
+
+   private:
+      // a[k] = sum(i) lo[2i] * even[k+i] + lo[2i+1] * odd[k+i], periodic in k
+      void Analyse(const TData *px, int half, TData *pa, TData *pd) const
+      {
+         const int taps = GetFilterLength() / 2;
+         const int extended = half + taps + P::Width;
+         std::vector<TData> even(extended), odd(extended);
+         for (int m = 0; m < extended; ++m) {
+            even[m] = px[(2 * m) % (2 * half)];
+            odd[m] = px[(2 * m + 1) % (2 * half)];
+         }
+
+         for (int k = 0; k < half; k += P::Width) {
+            P a((TData)0.0), d((TData)0.0);
+            for (int i = 0; i < taps; ++i) {
+               P e = P::Load(&even[k + i]);
+               P o = P::Load(&odd[k + i]);
+               a = a + P(m_lo[2 * i]) * e + P(m_lo[2 * i + 1]) * o;
+               d = d + P(m_hi[2 * i]) * e + P(m_hi[2 * i + 1]) * o;
+            }
+            StoreClipped(a, pa + k, half - k);
+            StoreClipped(d, pd + k, half - k);
+         }
+      }
+      // x[2m] = sum(i) lo[2i] * a[m-i] + hi[2i] * d[m-i], x[2m+1] likewise with odd taps
+      void Synthesize(const TData *pa, const TData *pd, int half, TData *px) const
+      {
+         const int taps = GetFilterLength() / 2;
+         const int offset = taps - 1; // history in front of a[0]
+         const int extended = half + offset + P::Width;
+         std::vector<TData> a(extended), d(extended), even(half + P::Width), odd(half + P::Width);
+         for (int m = 0; m < extended; ++m) {
+            int src = ((m - offset) % half + half) % half;
+            a[m] = pa[src];
+            d[m] = pd[src];
+         }
+
+         for (int m = 0; m < half; m += P::Width) {
+            P e((TData)0.0), o((TData)0.0);
+            for (int i = 0; i < taps; ++i) {
+               P va = P::Load(&a[m - i + offset]);
+               P vd = P::Load(&d[m - i + offset]);
+               e = e + P(m_lo[2 * i]) * va + P(m_hi[2 * i]) * vd;
+               o = o + P(m_lo[2 * i + 1]) * va + P(m_hi[2 * i + 1]) * vd;
+            }
+            e.Store(&even[m]);
+            o.Store(&odd[m]);
+         }
+         for (int m = 0; m < half; ++m) {
+            px[2 * m] = even[m];
+            px[2 * m + 1] = odd[m];
+         }
+      }
+      static void StoreClipped(P value, TData *pdest, int room)
+      {
+         if (room >= P::Width) {
+            value.Store(pdest);
+         }
+         else {
+            TData tmp[P::Width];
+            value.Store(tmp);
+            std::copy(tmp, tmp + room, pdest);
+         }
+      }
+   };
+}
@@ -0,0 +1,42 @@
+/*
+*    Copyright 2017 Mikhail Vasilyev
+*
+*    Licensed under the Apache License, Version 2.0 (the "License");
+*    you may not use this file except in compliance with the License.
+*    You may obtain a copy of the License at
+*
+*        http://www.apache.org/licenses/LICENSE-2.0
+*
+*    Unless required by applicable law or agreed to in writing, software
+*    distributed under the License is distributed on an "AS IS" BASIS,
+*    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+*    See the License for the specific language governing permissions and
+*    limitations under the License.
+*/
+#pragma once
+
+namespace Processing
+{
+   /// <summary>
+   /// Orthogonal wavelets available for discrete wavelet decomposition
+   /// </summary>
+   public enum class WaveletFamily
+   {
+      /// <summary>
+      /// 2 taps, best time resolution, poor frequency separation
+      /// </summary>
+      Haar,
+      /// <summary>
+      /// Daubechies, 2 vanishing moments, 4 taps
+      /// </summary>
+      Daubechies2,
+      /// <summary>
+      /// Daubechies, 4 vanishing moments, 8 taps
+      /// </summary>
+      Daubechies4,
+      /// <summary>
+      /// Least asymmetric Daubechies, 4 vanishing moments, 8 taps
+      /// </summary>
+      Symlet4
+   };
+}
@@ -18,9 +18,16 @@
 #include <cassert>
 #include <complex>
 #include <cmath>
+#include <algorithm>
 #include <type_traits>
 #include "ISpectralAnalysis.h"
 #include "IHilbertSpectrum.h"
+#include "HilbertOptions.h"
+#include "Kernels.h"
+#include "Histogram.h"
+#include "Raster.h"
+#include "Features.h"
+#include "Storage.h"
 
 using namespace Platform;
 using namespace Platform::Collections;
@@ -217,48 +224,45 @@ namespace Processing
 
 #pragma region Instantaneous Analysis
 
+   // Amplitudes and phases receive n values, frequencies n-1; pphase may be null when phases are not needed
    template <typename TData, REQUIRES_FLOAT(TData)>
-   private ref class SpectralAnalyzerBase
+   inline void ComputeInstAttributes(const TData *px, int n, TData timestep, InstFrequencyMethod method, Demodulator demodulator,
+                                     TData *pampl, TData *pphase, TData *pfreq, TData *pminFreq, TData *pmaxFreq)
    {
-      typedef std::unique_ptr<TData[]> Uptr;
-      typedef std::unique_ptr<std::complex<TData>[]> Cuptr;
+      if (demodulator == Demodulator::TeagerKaiser) {
+         TeagerKaiserKernel<TData>::Compute(px, n, timestep, pampl, pphase, pfreq, pminFreq, pmaxFreq);
+         return;
+      }
+
+      std::unique_ptr<TData[]> pdata = std::make_unique<TData[]>(n);
+      memcpy(pdata.get(), px, sizeof(TData) * n);
+
+      std::unique_ptr<std::complex<TData>[]> hilberted = HilbertTransform<TData>::Forward(std::move(pdata), n);
 
+      InstAttributesKernel<TData>::Compute(hilberted.get(), n, timestep, method == InstFrequencyMethod::AnalyticDerivative,
+                                           pampl, pphase, pfreq, pminFreq, pmaxFreq);
+   }
+
+   template <typename TData, REQUIRES_FLOAT(TData)>
+   private ref class SpectralAnalyzerBase
+   {
    private protected:
       const int m_length;
       Array<TData>^ m_pInstAmpl;
       Array<TData>^ m_pInstPhas;
       Array<TData>^ m_pInstFreq;
+      TData m_minFreq, m_maxFreq;
 
    internal:
-      SpectralAnalyzerBase(const Array<TData>^ yValues, TData timeStep) : m_length(yValues->Length),
-         m_pInstAmpl(ref new Array<TData>(m_length)), m_pInstPhas(ref new Array<TData>(m_length)), m_pInstFreq(ref new Array<TData>(m_length - 1))
+      SpectralAnalyzerBase(const Array<TData>^ yValues, TData timeStep, InstFrequencyMethod method = InstFrequencyMethod::PhaseDifference,
+                           Demodulator demodulator = Demodulator::Hilbert)
+         : m_length(yValues->Length),
+         m_pInstAmpl(ref new Array<TData>(m_length)), m_pInstPhas(ref new Array<TData>(m_length)), m_pInstFreq(ref new Array<TData>(m_length - 1)),
+         m_minFreq(0.0), m_maxFreq(0.0)
       {
          assert(yValues->Length > 0);
-         Uptr pdata = std::make_unique<TData[]>(m_length);
-         memcpy(pdata.get(), yValues->Data, sizeof(TData) * m_length);
-
-         Cuptr hilberted = HilbertTransform<TData>::Forward(std::move(pdata), m_length);
-
-         auto fillAmplTask = [&hilberted, this]() {
-            for (int i = 0; i < m_length; ++i)
-               this->m_pInstAmpl[i] = std::sqrt(hilberted[i].real() * hilberted[i].real() + hilberted[i].imag() * hilberted[i].imag());            
-         };
-         auto fillPhasFreqTask = [&hilberted, this, timeStep]() {
-            TData invTimestep = 1.0 / timeStep;
-            this->m_pInstPhas[0] = std::atan2(hilberted[0].imag(), hilberted[0].real());
-            for (int i = 1; i < m_length; ++i) {
-               this->m_pInstPhas[i] = std::atan2(hilberted[i].imag(), hilberted[i].real());
-               this->m_pInstFreq[i - 1] = (m_pInstPhas[i - 1] - m_pInstPhas[i]) * invTimestep;
-            }
-         };
-
-         if (m_length >= 100) {
-            concurrency::parallel_invoke(fillPhasFreqTask, fillAmplTask);
-         }
-         else {
-            fillAmplTask();
-            fillPhasFreqTask();
-         }
+         ComputeInstAttributes<TData>(yValues->Data, m_length, timeStep, method, demodulator,
+                                      m_pInstAmpl->Data, m_pInstPhas->Data, m_pInstFreq->Data, &m_minFreq, &m_maxFreq);
       }
       TData GetAmplitudeAt(int i) const
       {
@@ -275,10 +279,26 @@ namespace Processing
          assert(i < m_length - 1);
          return m_pInstFreq[i];
       }
+      const TData *GetAmplitudes() const noexcept
+      {
+         return m_pInstAmpl->Data;
+      }
+      const TData *GetFrequencies() const noexcept
+      {
+         return m_pInstFreq->Data;
+      }
       int GetLength() const noexcept
       {
          return m_length;
       }
+      TData GetMinFrequency() const noexcept
+      {
+         return m_minFreq;
+      }
+      TData GetMaxFrequency() const noexcept
+      {
+         return m_maxFreq;
+      }
    };
 
    template <typename TData>
@@ -288,8 +308,9 @@ namespace Processing
    private ref class SpectralAnalyzer<double> : public SpectralAnalyzerBase<double>, public Double::ISpectralAnalysis
    {
    internal:
-      SpectralAnalyzer(const Array<double>^ yValues, double timeStep) 
-         : SpectralAnalyzerBase(yValues, timeStep)
+      SpectralAnalyzer(const Array<double>^ yValues, double timeStep, InstFrequencyMethod method = InstFrequencyMethod::PhaseDifference,
+                       Demodulator demodulator = Demodulator::Hilbert)
+         : SpectralAnalyzerBase(yValues, timeStep, method, demodulator)
       { }
    public:
       // Inherited via ISpectralAnalysis
@@ -317,8 +338,9 @@ namespace Processing
    private ref class SpectralAnalyzer<float> : public SpectralAnalyzerBase<float>, public Single::ISpectralAnalysis
    {
    internal:
-      SpectralAnalyzer(const Array<float>^ yValues, float timeStep)
-         : SpectralAnalyzerBase(yValues, timeStep)
+      SpectralAnalyzer(const Array<float>^ yValues, float timeStep, InstFrequencyMethod method = InstFrequencyMethod::PhaseDifference,
+                       Demodulator demodulator = Demodulator::Hilbert)
+         : SpectralAnalyzerBase(yValues, timeStep, method, demodulator)
       { }
    public:
       // Inherited via ISpectralAnalysis
@@ -350,48 +372,73 @@ namespace Processing
    template <typename TData, REQUIRES_FLOAT(TData)>
    private ref class HilbertSpectrumBase
    {
-      typedef SpectralAnalyzerBase<TData>^ AnalyzerPtr;
-
    private protected:
-      std::vector<AnalyzerPtr> m_analyses;
+      ImfAttributeStore<TData> m_store;
       TData m_maxFreq, m_minFreq;
       TData m_timestep;
 
-      HilbertSpectrumBase(IVector<IVector<TData>^>^ imfs, TData timestep) : m_analyses(imfs->Size), m_maxFreq(0.0), m_minFreq(0.0), m_timestep(timestep)
+      HilbertSpectrumBase(IVector<IVector<TData>^>^ imfs, TData timestep, HilbertOptions^ options)
+         : m_store(imfs->Size, imfs->GetAt(0)->Size, options ? options->FrequencyStorage : FrequencyStorage::Full),
+         m_maxFreq(0.0), m_minFreq(0.0), m_timestep(timestep)
       {
          assert(imfs->Size > 0);
-         concurrency::parallel_for((size_t)0, (size_t)(imfs->Size), [this, imfs](size_t i) {
-            IVector<TData>^ imf = imfs->GetAt(i);
-            Array<TData>^ pdata = ref new Array<TData>(imf->Size);
-            std::copy(begin(imf), end(imf), pdata->begin());
-            this->m_analyses[i] = ref new SpectralAnalyzerBase<TData>(pdata, this->m_timestep);
+         const InstFrequencyMethod method = options ? options->FrequencyMethod : InstFrequencyMethod::PhaseDifference;
+         const Demodulator demodulator = options ? options->Demodulator : Demodulator::Hilbert;
+         const double clip = options ? options->FrequencyClipPercent / 100.0 : 0.0;
+         const int length = m_store.GetLength();
+
+         // phase differences lie within [-pi/dt, pi/dt], other estimators are clamped to it
+         const TData nyquist = (TData)3.14159265358979324 / timestep;
+         concurrency::combinable<FrequencyCounter<TData>> counters([nyquist]() {
+            return FrequencyCounter<TData>(-nyquist, nyquist);
          });
-         
-         m_maxFreq = m_minFreq = (m_analyses[0])->GetFrequencyAt(0);
-         for (const AnalyzerPtr& pAnalyzer : m_analyses) {
-            for (int i = 0; i < pAnalyzer->GetLength() - 1; ++i) {
-               TData freq = pAnalyzer->GetFrequencyAt(i);
-               if (freq < m_minFreq)
-                  m_minFreq = freq;
-               else if (freq > m_maxFreq)
-                  m_maxFreq = freq;
+         std::vector<TData> minFreqs(imfs->Size), maxFreqs(imfs->Size);
+
+         // the frequency range is a by-product of the attribute pass, reduced below;
+         // phases are never exposed by the spectrum, so they are not computed at all
+         concurrency::parallel_for((size_t)0, (size_t)(imfs->Size), [&, this](size_t i) {
+            IVector<TData>^ imf = imfs->GetAt(i);
+            assert((int)imf->Size == length);
+            std::vector<TData> data(begin(imf), end(imf));
+
+            std::vector<TData> packed;
+            TData *pfreq = m_store.GetFrequencyBuffer((int)i);
+            if (!pfreq) {
+               packed.resize(length - 1);
+               pfreq = packed.data();
             }
+            ComputeInstAttributes<TData>(data.data(), length, m_timestep, method, demodulator,
+                                         m_store.GetAmplitudes((int)i), nullptr, pfreq, &minFreqs[i], &maxFreqs[i]);
+            if (clip > 0.0)
+               counters.local().Add(pfreq, length - 1);
+            m_store.StoreFrequencies((int)i, pfreq, minFreqs[i], maxFreqs[i]);
+         });
+
+         m_minFreq = *std::min_element(minFreqs.begin(), minFreqs.end());
+         m_maxFreq = *std::max_element(maxFreqs.begin(), maxFreqs.end());
+
+         if (clip > 0.0) {
+            // wrap-around spikes would otherwise dominate the range
+            FrequencyCounter<TData> total(-nyquist, nyquist);
+            counters.combine_each([&total](const FrequencyCounter<TData>& c) { total.Merge(c); });
+            m_minFreq = std::max(m_minFreq, total.Percentile(clip));
+            m_maxFreq = std::min(m_maxFreq, total.Percentile(1.0 - clip));
          }
       }
       TData GetSpectrumAt(TData w, int t, TData maxError) const
       {
          TData res = 0.0;
-         for (const AnalyzerPtr& pAnalysis : m_analyses) {
-            TData error = pAnalysis->GetFrequencyAt(t) - w;
+         for (int imf = 0; imf < m_store.GetImfCount(); ++imf) {
+            TData error = m_store.GetFrequencyAt(imf, t) - w;
             if (error < maxError && error > -maxError) {
-               res += pAnalysis->GetAmplitudeAt(t);
+               res += m_store.GetAmplitudeAt(imf, t);
             }
          }
          return res;
       }
       TData GetMarginalAt(TData w, TData maxError) const
       {
-         const int length = (m_analyses[0])->GetLength() - 1;
+         const int length = m_store.GetLength() - 1;
          TData res = 0.0;
          for (int i = 1; i < length; ++i) {
             // linear interpolation
@@ -400,6 +447,60 @@ namespace Processing
          }
          return res;
       }
+      // Single O(T*K) sweep producing marginal values for all bins at once
+      HilbertHistogram<TData> GetHistogram(int binCount, TData fmin, TData fmax, bool keepGrid) const
+      {
+         if (binCount <= 0 || !(fmax > fmin))
+            throw ref new InvalidArgumentException();
+
+         HilbertHistogram<TData> hist(binCount, fmin, fmax, m_store.GetLength() - 1, m_timestep, keepGrid);
+         std::vector<TData> scratch;
+         for (int imf = 0; imf < m_store.GetImfCount(); ++imf) {
+            hist.Accumulate(m_store.GetAmplitudes(imf), m_store.GetFrequencies(imf, &scratch));
+         }
+         return hist;
+      }
+      Array<TData>^ GetMarginal(int binCount, TData fmin, TData fmax) const
+      {
+         HilbertHistogram<TData> hist = GetHistogram(binCount, fmin, fmax, false);
+         Array<TData>^ pres = ref new Array<TData>(binCount);
+         std::copy(hist.GetMarginal(), hist.GetMarginal() + binCount, pres->begin());
+         return pres;
+      }
+      void Render(TData tmin, TData tmax, TData fmin, TData fmax, int width, int height,
+                  bool logScale, TData sigma, WriteOnlyArray<TData>^ image) const
+      {
+         if (width <= 0 || height <= 0 || !(tmax > tmin) || !(fmax > fmin) || image->Length < (uint64_t)width * height)
+            throw ref new InvalidArgumentException();
+
+         std::vector<const TData *> ampl, freq;
+         std::vector<std::vector<TData>> decoded(m_store.GetImfCount());
+         for (int imf = 0; imf < m_store.GetImfCount(); ++imf) {
+            ampl.push_back(m_store.GetAmplitudes(imf));
+            freq.push_back(m_store.GetFrequencies(imf, &decoded[imf]));
+         }
+         HilbertRasterizer<TData> raster(std::move(ampl), std::move(freq), m_store.GetLength() - 1);
+         raster.Render(tmin, tmax, fmin, fmax, width, height, logScale, sigma, image->Data);
+      }
+      Array<TData>^ GetGrid(int binCount, TData fmin, TData fmax) const
+      {
+         HilbertHistogram<TData> hist = GetHistogram(binCount, fmin, fmax, true);
+         Array<TData>^ pres = ref new Array<TData>(binCount * hist.GetLength());
+         std::copy(hist.GetGrid(), hist.GetGrid() + pres->Length, pres->begin());
+         return pres;
+      }
+
+   internal:
+      void ExtractFeatures(const ImfFeatureExtractor<TData>& extractor, TData *pout) const
+      {
+         std::vector<const TData *> ampl, freq;
+         std::vector<std::vector<TData>> decoded(m_store.GetImfCount());
+         for (int imf = 0; imf < m_store.GetImfCount(); ++imf) {
+            ampl.push_back(m_store.GetAmplitudes(imf));
+            freq.push_back(m_store.GetFrequencies(imf, &decoded[imf]));
+         }
+         extractor.Extract(ampl, freq, m_store.GetLength() - 1, m_timestep, pout);
+      }
    };
 
    template <typename TData>
@@ -409,7 +510,8 @@ namespace Processing
    private ref class HilbertSpectrum<double> : public HilbertSpectrumBase<double>, public Double::IHilbertSpectrum
    {
    internal:
-      HilbertSpectrum(IVector<IVector<double>^>^ imfs, double timestep) : HilbertSpectrumBase(imfs, timestep)
+      HilbertSpectrum(IVector<IVector<double>^>^ imfs, double timestep, HilbertOptions^ options = nullptr)
+         : HilbertSpectrumBase(imfs, timestep, options)
       { }
 
    public:
@@ -436,13 +538,27 @@ namespace Processing
          double error = (m_maxFreq - m_minFreq) / 1000.0;
          return GetMarginalAt(w, error);
       }
+      virtual Array<double>^ ComputeMarginal(int32 binCount, double minFrequency, double maxFrequency)
+      {
+         return GetMarginal(binCount, minFrequency, maxFrequency);
+      }
+      virtual Array<double>^ ComputeHistogram(int32 binCount, double minFrequency, double maxFrequency)
+      {
+         return GetGrid(binCount, minFrequency, maxFrequency);
+      }
+      virtual void Rasterize(double minTime, double maxTime, double minFrequency, double maxFrequency, int32 width, int32 height,
+                             bool logScale, double smoothing, WriteOnlyArray<double>^ image)
+      {
+         Render(minTime, maxTime, minFrequency, maxFrequency, width, height, logScale, smoothing, image);
+      }
    };
 
    template<>
    private ref class HilbertSpectrum<float> : public HilbertSpectrumBase<float>, public Single::IHilbertSpectrum
    {
    internal:
-      HilbertSpectrum(IVector<IVector<float>^>^ imfs, float timestep) : HilbertSpectrumBase(imfs, timestep)
+      HilbertSpectrum(IVector<IVector<float>^>^ imfs, float timestep, HilbertOptions^ options = nullptr)
+         : HilbertSpectrumBase(imfs, timestep, options)
       { }
 
    public:
@@ -469,6 +585,19 @@ namespace Processing
          float error = (m_maxFreq - m_minFreq) / 1000.0f;
          return GetMarginalAt(w, error);
       }
+      virtual Array<float>^ ComputeMarginal(int32 binCount, float minFrequency, float maxFrequency)
+      {
+         return GetMarginal(binCount, minFrequency, maxFrequency);
+      }
+      virtual Array<float>^ ComputeHistogram(int32 binCount, float minFrequency, float maxFrequency)
+      {
+         return GetGrid(binCount, minFrequency, maxFrequency);
+      }
+      virtual void Rasterize(float minTime, float maxTime, float minFrequency, float maxFrequency, int32 width, int32 height,
+                             bool logScale, float smoothing, WriteOnlyArray<float>^ image)
+      {
+         Render(minTime, maxTime, minFrequency, maxFrequency, width, height, logScale, smoothing, image);
+      }
    };
 
 #pragma endregion
@@ -0,0 +1,128 @@
+/*
+*    Copyright 2017 Mikhail Vasilyev
+*
+*    Licensed under the Apache License, Version 2.0 (the "License");
+*    you may not use this file except in compliance with the License.
+*    You may obtain a copy of the License at
+*
+*        http://www.apache.org/licenses/LICENSE-2.0
+*
+*    Unless required by applicable law or agreed to in writing, software
+*    distributed under the License is distributed on an "AS IS" BASIS,
+*    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+*    See the License for the specific language governing permissions and
+*    limitations under the License.
+*/
+#include "pch.h"
+#include <vector>
+#include <algorithm>
+#include "Analysis.h"
+#include "Welch.h"
+#include "FeatureExtractor.h"
+
+using namespace Processing;
+using namespace Platform;
+
+template<typename TData, typename = std::enable_if_t<std::is_floating_point_v<TData>>>
+inline std::vector<TData> CheckedEdges(const Array<TData>^ bandEdges)
+{
+   if (bandEdges->Length < 2 || !std::is_sorted(bandEdges->begin(), bandEdges->end()))
+      throw ref new InvalidArgumentException();
+   return std::vector<TData>(bandEdges->begin(), bandEdges->end());
+}
+
+template<typename TData, typename TSpectrum>
+inline void ExtractAll(const ImfFeatureExtractor<TData>& extractor, const Array<TSpectrum^>^ spectra, WriteOnlyArray<TData>^ features)
+{
+   const int count = extractor.GetFeatureCount();
+   if (features->Length < spectra->Length * (unsigned)count)
+      throw ref new InvalidArgumentException();
+
+   std::vector<HilbertSpectrumBase<TData>^> hs(spectra->Length);
+   for (unsigned i = 0; i < spectra->Length; ++i)
+      hs[i] = spectra[i] == nullptr ? nullptr : safe_cast<HilbertSpectrumBase<TData>^>(spectra[i]);
+
+   TData *pout = features->Data;
+   concurrency::parallel_for((size_t)0, hs.size(), [&](size_t i) {
+      if (hs[i] == nullptr)
+         std::fill(pout + i * count, pout + (i + 1) * count, (TData)0.0);
+      else
+         hs[i]->ExtractFeatures(extractor, pout + i * count);
+   });
+}
+
+template<typename TData>
+inline void ExtractAllSpectral(const ImfFeatureExtractor<TData>& extractor, const Array<TData>^ channelData, int channelCount,
+                               TData timestep, int segmentLength, WriteOnlyArray<TData>^ features)
+{
+   const int count = extractor.GetFeatureCount();
+   if (channelCount <= 0 || channelData->Length % channelCount != 0 || !(timestep > 0) || segmentLength <= 0 ||
+       features->Length < (uint64_t)channelCount * count)
+      throw ref new InvalidArgumentException();
+
+   const int length = channelData->Length / channelCount;
+   if (length == 0)
+      throw ref new InvalidArgumentException();
+
+   // the largest power of 2 that fits, a segment longer than the data would be mostly zero padding
+   int fitting = 2;
+   while (fitting * 2 <= std::min(segmentLength, length))
+      fitting *= 2;
+   WelchEstimator<TData> welch(fitting);
+   const TData binSpacing = (TData)(2 * M_PI) / (welch.GetSegmentLength() * timestep);
+   const TData *pdata = channelData->Data;
+   TData *pout = features->Data;
+
+   concurrency::parallel_for(0, channelCount, [&](int c) {
+      std::vector<TData> psd(welch.GetBinCount());
+      welch.Compute(pdata + (size_t)c * length, length, timestep, psd.data());
+      extractor.ExtractSpectral(psd.data(), welch.GetBinCount(), binSpacing, length, timestep, pout + (size_t)c * count);
+   });
+}
+
+Processing::Single::FeatureExtractor::FeatureExtractor(const Array<float>^ bandEdges, int32 imfCount, float energyThreshold)
+{
+   if (imfCount < 0)
+      throw ref new InvalidArgumentException();
+   m_pe = std::make_unique<ImfFeatureExtractor<float>>(CheckedEdges(bandEdges), imfCount, energyThreshold);
+}
+
+void Processing::Single::FeatureExtractor::Extract(const Array<IHilbertSpectrum^>^ spectra, WriteOnlyArray<float>^ features)
+{
+   ExtractAll(*m_pe, spectra, features);
+}
+
+void Processing::Single::FeatureExtractor::ExtractSpectral(const Array<float>^ channelData, int32 channelCount, float timeStep,
+                                                        int32 segmentLength, WriteOnlyArray<float>^ features)
+{
+   ExtractAllSpectral(*m_pe, channelData, channelCount, timeStep, segmentLength, features);
+}
+
+int32 Processing::Single::FeatureExtractor::FeatureCount::get()
+{
+   return m_pe->GetFeatureCount();
+}
+
+
+Processing::Double::FeatureExtractor::FeatureExtractor(const Array<double>^ bandEdges, int32 imfCount, double energyThreshold)
+{
+   if (imfCount < 0)
+      throw ref new InvalidArgumentException();
+   m_pe = std::make_unique<ImfFeatureExtractor<double>>(CheckedEdges(bandEdges), imfCount, energyThreshold);
+}
+
+void Processing::Double::FeatureExtractor::Extract(const Array<IHilbertSpectrum^>^ spectra, WriteOnlyArray<double>^ features)
+{
+   ExtractAll(*m_pe, spectra, features);
+}
+
+void Processing::Double::FeatureExtractor::ExtractSpectral(const Array<double>^ channelData, int32 channelCount, double timeStep,
+                                                        int32 segmentLength, WriteOnlyArray<double>^ features)
+{
+   ExtractAllSpectral(*m_pe, channelData, channelCount, timeStep, segmentLength, features);
+}
+
+int32 Processing::Double::FeatureExtractor::FeatureCount::get()
+{
+   return m_pe->GetFeatureCount();
+}
@@ -0,0 +1,110 @@
+/*
+*    Copyright 2017 Mikhail Vasilyev
+*
+*    Licensed under the Apache License, Version 2.0 (the "License");
+*    you may not use this file except in compliance with the License.
+*    You may obtain a copy of the License at
+*
+*        http://www.apache.org/licenses/LICENSE-2.0
+*
+*    Unless required by applicable law or agreed to in writing, software
+*    distributed under the License is distributed on an "AS IS" BASIS,
+*    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+*    See the License for the specific language governing permissions and
+*    limitations under the License.
+*/
+#pragma once
+#include <memory>
+#include "IHilbertSpectrum.h"
+#include "Features.h"
+
+using namespace Platform;
+
+namespace Processing
+{
+   namespace Single
+   {
+      /// <summary>
+      /// Single-precision classifier input from Hilbert spectra: fixed frequency bands followed by per-IMF statistics
+      /// (energy, mean frequency, amplitude mean and standard deviation)
+      /// </summary>
+      public ref class FeatureExtractor sealed
+      {
+         std::unique_ptr<Processing::ImfFeatureExtractor<float>> m_pe;
+
+      public:
+         /// <summary>
+         /// Creates an extractor with a fixed feature layout
+         /// </summary>
+         /// <param name="bandEdges">Ascending band boundaries in the units of IHilbertSpectrum frequencies</param>
+         /// <param name="imfCount">Number of IMFs described individually</param>
+         /// <param name="energyThreshold">IMFs with a smaller fraction of the total energy are ignored</param>
+         FeatureExtractor(const Array<float>^ bandEdges, int32 imfCount, float energyThreshold);
+
+         /// <summary>
+         /// Features of all channels at once, row-major [channel][FeatureCount]. Null spectra give zero rows.
+         /// </summary>
+         void Extract(const Array<IHilbertSpectrum^>^ spectra, WriteOnlyArray<float>^ features);
+
+         /// <summary>
+         /// Same feature layout from Welch power spectra of raw channel data, a low-cost fallback for the Hilbert path.
+         /// Only the band features are filled.
+         /// </summary>
+         /// <param name="channelData">Samples, row-major [channel][time step]</param>
+         /// <param name="channelCount">Number of channels</param>
+         /// <param name="timeStep">Interval between samples</param>
+         /// <param name="segmentLength">Welch segment length, rounded down to a power of 2 and to at most the samples per channel</param>
+         /// <param name="features">Row-major [channel][FeatureCount]</param>
+         void ExtractSpectral(const Array<float>^ channelData, int32 channelCount, float timeStep, int32 segmentLength,
+                              WriteOnlyArray<float>^ features);
+
+         /// <summary>
+         /// Number of features per channel
+         /// </summary>
+         property int32 FeatureCount { int32 get(); }
+      };
+   }
+
+   namespace Double
+   {
+      /// <summary>
+      /// Double-precision classifier input from Hilbert spectra: fixed frequency bands followed by per-IMF statistics
+      /// (energy, mean frequency, amplitude mean and standard deviation)
+      /// </summary>
+      public ref class FeatureExtractor sealed
+      {
+         std::unique_ptr<Processing::ImfFeatureExtractor<double>> m_pe;
+
+      public:
+         /// <summary>
+         /// Creates an extractor with a fixed feature layout
+         /// </summary>
+         /// <param name="bandEdges">Ascending band boundaries in the units of IHilbertSpectrum frequencies</param>
+         /// <param name="imfCount">Number of IMFs described individually</param>
+         /// <param name="energyThreshold">IMFs with a smaller fraction of the total energy are ignored</param>
+         FeatureExtractor(const Array<double>^ bandEdges, int32 imfCount, double energyThreshold);
+
+         /// <summary>
+         /// Features of all channels at once, row-major [channel][FeatureCount]. Null spectra give zero rows.
+         /// </summary>
+         void Extract(const Array<IHilbertSpectrum^>^ spectra, WriteOnlyArray<double>^ features);
+
+         /// <summary>
+         /// Same feature layout from Welch power spectra of raw channel data, a low-cost fallback for the Hilbert path.
+         /// Only the band features are filled.
+         /// </summary>
+         /// <param name="channelData">Samples, row-major [channel][time step]</param>
+         /// <param name="channelCount">Number of channels</param>
+         /// <param name="timeStep">Interval between samples</param>
+         /// <param name="segmentLength">Welch segment length, rounded down to a power of 2 and to at most the samples per channel</param>
+         /// <param name="features">Row-major [channel][FeatureCount]</param>
+         void ExtractSpectral(const Array<double>^ channelData, int32 channelCount, double timeStep, int32 segmentLength,
+                              WriteOnlyArray<double>^ features);
+
+         /// <summary>
+         /// Number of features per channel
+         /// </summary>
+         property int32 FeatureCount { int32 get(); }
+      };
+   }
+}
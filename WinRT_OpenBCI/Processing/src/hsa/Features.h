@@ -0,0 +1,175 @@
+/*
+*    Copyright 2017 Mikhail Vasilyev
+*
+*    Licensed under the Apache License, Version 2.0 (the "License");
+*    you may not use this file except in compliance with the License.
+*    You may obtain a copy of the License at
+*
+*        http://www.apache.org/licenses/LICENSE-2.0
+*
+*    Unless required by applicable law or agreed to in writing, software
+*    distributed under the License is distributed on an "AS IS" BASIS,
+*    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+*    See the License for the specific language governing permissions and
+*    limitations under the License.
+*/
+#pragma once
+#include <vector>
+#include <cmath>
+#include <cassert>
+#include <algorithm>
+#include <type_traits>
+#include "../simd/Simd.h"
+
+namespace Processing
+{
+   /// <summary>
+   /// Fixed-layout feature vector of one channel's Hilbert spectrum:
+   /// [marginal spectrum integrated over each band | energy, mean frequency, amplitude mean, amplitude sd of each IMF].
+   /// IMFs carrying less than the threshold fraction of the channel's energy are left out of both parts.
+   /// </summary>
+   template <typename TData, typename = std::enable_if_t<std::is_floating_point_v<TData>>>
+   class ImfFeatureExtractor final
+   {
+      typedef Pack<TData> P;
+
+      struct ImfStats
+      {
+         TData energy, sumA, sumA2, sumA2F;
+         std::vector<TData> below; // [edge], marginal below each band edge
+      };
+
+      std::vector<TData> m_edges;
+      const int m_imfSlots;
+      const TData m_threshold;
+
+   public:
+      static constexpr int FEATURES_PER_IMF = 4;
+
+      // edges - ascending band boundaries, bands are [edges[i], edges[i+1])
+      // imfSlots - number of IMFs described individually, the rest only contribute to bands
+      // threshold - minimum fraction of the total energy an IMF must carry
+      ImfFeatureExtractor(std::vector<TData> edges, int imfSlots, TData threshold)
+         : m_edges(std::move(edges)), m_imfSlots(imfSlots), m_threshold(threshold)
+      {
+         assert(m_edges.size() >= 2 && std::is_sorted(m_edges.begin(), m_edges.end()));
+         assert(imfSlots >= 0);
+      }
+      int GetBandCount() const noexcept
+      {
+         return (int)m_edges.size() - 1;
+      }
+      int GetImfSlots() const noexcept
+      {
+         return m_imfSlots;
+      }
+      int GetFeatureCount() const noexcept
+      {
+         return GetBandCount() + FEATURES_PER_IMF * m_imfSlots;
+      }
+      // ampl[k] and freq[k] hold length values of the k-th IMF. Writes GetFeatureCount() values to pout.
+      // Band values use the same time weighting as HilbertSpectrumBase::GetMarginalAt.
+      void Extract(const std::vector<const TData *>& ampl, const std::vector<const TData *>& freq,
+                   int length, TData timestep, TData *pout) const
+      {
+         assert(ampl.size() == freq.size());
+         std::fill(pout, pout + GetFeatureCount(), (TData)0.0);
+         if (length < 2 || ampl.empty())
+            return;
+
+         std::vector<ImfStats> stats(ampl.size());
+         TData total = 0;
+         for (size_t k = 0; k < ampl.size(); ++k) {
+            Accumulate(ampl[k], freq[k], length, timestep * timestep, &stats[k]);
+            total += stats[k].energy;
+         }
+
+         TData *pbands = pout;
+         TData *pimfs = pout + GetBandCount();
+         int slot = 0;
+         for (const ImfStats& s : stats) {
+            if (!(s.energy > m_threshold * total))
+               continue;
+            for (int b = 0; b < GetBandCount(); ++b)
+               pbands[b] += s.below[b + 1] - s.below[b];
+
+            if (slot < m_imfSlots) {
+               TData mean = s.sumA / length;
+               TData var = std::max(s.sumA2 / length - mean * mean, (TData)0.0);
+               pimfs[0] = s.energy;
+               pimfs[1] = s.sumA2 > 0 ? s.sumA2F / s.sumA2 : (TData)0.0;
+               pimfs[2] = mean;
+               pimfs[3] = std::sqrt(var);
+               pimfs += FEATURES_PER_IMF;
+               slot++;
+            }
+         }
+      }
+
+      // Same layout from a one-sided PSD (see WelchEstimator), bin k at k * binSpacing, for when no Hilbert
+      // spectrum is available. A band holds the amplitude of a sinusoid carrying the band's power, scaled like
+      // the marginal of a length-sample signal, so narrowband components give the same value on both paths.
+      // The per-IMF part is left zero.
+      void ExtractSpectral(const TData *ppsd, int binCount, TData binSpacing, int length, TData timestep, TData *pout) const
+      {
+         std::fill(pout, pout + GetFeatureCount(), (TData)0.0);
+         if (length < 3)
+            return;
+
+         const TData twoPi = (TData)6.28318530717958648;
+         const TData binWidth = binSpacing / twoPi; // PSD is per Hz
+         const TData marginalScale = (length - 2) * timestep * timestep;
+
+         for (int b = 0; b < GetBandCount(); ++b) {
+            int first = std::max(0, (int)std::ceil(m_edges[b] / binSpacing));
+            TData power = 0;
+            for (int k = first; k < binCount && k * binSpacing < m_edges[b + 1]; ++k)
+               power += ppsd[k] * binWidth;
+            pout[b] = std::sqrt(2 * power) * marginalScale;
+         }
+      }
+
+   private:
+      // One vectorized sweep over an IMF: moments of the amplitude and the marginal below every band edge
+      void Accumulate(const TData *pampl, const TData *pfreq, int length, TData weight, ImfStats *ps) const
+      {
+         const int W = P::Width;
+         const int edgeCount = (int)m_edges.size();
+
+         P sumA((TData)0.0), sumA2((TData)0.0), sumA2F((TData)0.0);
+         std::vector<P> below(edgeCount, P((TData)0.0));
+
+         auto block = [&](P a, P f) {
+            P a2 = a * a;
+            sumA = sumA + a;
+            sumA2 = sumA2 + a2;
+            sumA2F = sumA2F + a2 * f;
+            for (int e = 0; e < edgeCount; ++e)
+               below[e] = below[e] + Select(f < P(m_edges[e]), a, P((TData)0.0));
+         };
+
+         int t = 0;
+         for (; t + W <= length; t += W)
+            block(P::Load(pampl + t), P::Load(pfreq + t));
+         if (t < length) {
+            // zero amplitude padding contributes nothing
+            TData a[W] = {}, f[W] = {};
+            std::copy(pampl + t, pampl + length, a);
+            std::copy(pfreq + t, pfreq + length, f);
+            block(P::Load(a), P::Load(f));
+         }
+
+         // trapezoidal rule: the end points only count half
+         const TData a0 = pampl[0], a1 = pampl[length - 1];
+         ps->sumA = sumA.Sum();
+         ps->sumA2 = sumA2.Sum();
+         ps->sumA2F = sumA2F.Sum();
+         ps->energy = (ps->sumA2 - (TData)0.5 * (a0 * a0 + a1 * a1)) * weight;
+         ps->below.resize(edgeCount);
+         for (int e = 0; e < edgeCount; ++e) {
+            TData ends = (pfreq[0] < m_edges[e] ? a0 : 0) + (pfreq[length - 1] < m_edges[e] ? a1 : 0);
+            ps->below[e] = (below[e].Sum() - (TData)0.5 * ends) * weight;
+         }
+      }
+   };
+}
@@ -0,0 +1,145 @@
+/*
+*    Copyright 2017 Mikhail Vasilyev
+*
+*    Licensed under the Apache License, Version 2.0 (the "License");
+*    you may not use this file except in compliance with the License.
+*    You may obtain a copy of the License at
+*
+*        http://www.apache.org/licenses/LICENSE-2.0
+*
+*    Unless required by applicable law or agreed to in writing, software
+*    distributed under the License is distributed on an "AS IS" BASIS,
+*    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+*    See the License for the specific language governing permissions and
+*    limitations under the License.
+*/
+#pragma once
+
+namespace Processing
+{
+   /// <summary>
+   /// How instantaneous frequency is obtained from the analytic signal
+   /// </summary>
+   public enum class InstFrequencyMethod
+   {
+      /// <summary>
+      /// Wrapped difference of successive phases
+      /// </summary>
+      PhaseDifference,
+      /// <summary>
+      /// Im(conj(z)*dz)/|z|^2 at the mid-point between samples, no arctangent evaluation
+      /// </summary>
+      AnalyticDerivative
+   };
+
+   /// <summary>
+   /// How instantaneous amplitude and frequency are estimated from each IMF
+   /// </summary>
+   public enum class Demodulator
+   {
+      /// <summary>
+      /// Analytic signal from an FFT-based Hilbert transform, two FFTs per IMF
+      /// </summary>
+      Hilbert,
+      /// <summary>
+      /// DESA-2 energy separation from a 5-sample stencil, no transform. Valid below a quarter of the sampling rate.
+      /// FrequencyMethod is ignored, phase is the integrated frequency.
+      /// </summary>
+      TeagerKaiser
+   };
+
+   /// <summary>
+   /// Precision of the instantaneous frequencies kept by a Hilbert spectrum
+   /// </summary>
+   public enum class FrequencyStorage
+   {
+      /// <summary>
+      /// Same precision as the input
+      /// </summary>
+      Full,
+      /// <summary>
+      /// IEEE half precision, 11 significant bits
+      /// </summary>
+      Half,
+      /// <summary>
+      /// 16-bit steps spread linearly over each IMF's frequency range
+      /// </summary>
+      Quantized16
+   };
+
+   /// <summary>
+   /// Optional settings for Hilbert spectral analysis
+   /// </summary>
+   public ref class HilbertOptions sealed
+   {
+      InstFrequencyMethod m_freqMethod;
+      double m_clipPercent;
+      Processing::Demodulator m_demodulator;
+      Processing::FrequencyStorage m_storage;
+
+   public:
+      HilbertOptions() : m_freqMethod(InstFrequencyMethod::PhaseDifference), m_clipPercent(0.0),
+         m_demodulator(Processing::Demodulator::Hilbert), m_storage(Processing::FrequencyStorage::Full)
+      { }
+
+      /// <summary>
+      /// Amplitude and frequency estimator, Hilbert by default
+      /// </summary>
+      property Processing::Demodulator Demodulator {
+         Processing::Demodulator get()
+         {
+            return m_demodulator;
+         }
+         void set(Processing::Demodulator value)
+         {
+            m_demodulator = value;
+         }
+      }
+
+      /// <summary>
+      /// Frequency precision kept by the spectrum, Full by default. 16-bit storage halves or quarters
+      /// the memory of frequencies, amplitudes are always kept in full precision.
+      /// </summary>
+      property Processing::FrequencyStorage FrequencyStorage {
+         Processing::FrequencyStorage get()
+         {
+            return m_storage;
+         }
+         void set(Processing::FrequencyStorage value)
+         {
+            m_storage = value;
+         }
+      }
+
+      /// <summary>
+      /// Instantaneous frequency estimator, PhaseDifference by default
+      /// </summary>
+      property InstFrequencyMethod FrequencyMethod {
+         InstFrequencyMethod get()
+         {
+            return m_freqMethod;
+         }
+         void set(InstFrequencyMethod value)
+         {
+            m_freqMethod = value;
+         }
+      }
+
+      /// <summary>
+      /// Percentage of instantaneous frequencies ignored at each end when MinFrequency and MaxFrequency
+      /// of a Hilbert spectrum are determined, 0 by default (exact range). Must be in [0, 50).
+      /// </summary>
+      property double FrequencyClipPercent {
+         double get()
+         {
+            return m_clipPercent;
+         }
+         void set(double value)
+         {
+            if (!(value >= 0.0 && value < 50.0))
+               throw ref new Platform::InvalidArgumentException();
+            m_clipPercent = value;
+         }
+      }
+   };
+}
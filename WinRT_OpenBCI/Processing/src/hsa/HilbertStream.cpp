@@ -0,0 +1,107 @@
+/*
+*    Copyright 2017 Mikhail Vasilyev
+*
+*    Licensed under the Apache License, Version 2.0 (the "License");
+*    you may not use this file except in compliance with the License.
+*    You may obtain a copy of the License at
+*
+*        http://www.apache.org/licenses/LICENSE-2.0
+*
+*    Unless required by applicable law or agreed to in writing, software
+*    distributed under the License is distributed on an "AS IS" BASIS,
+*    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+*    See the License for the specific language governing permissions and
+*    limitations under the License.
+*/
+#include "pch.h"
+#include "HilbertStream.h"
+
+using namespace Platform;
+
+Processing::Single::HilbertStream::HilbertStream(int32 tapCount, float timeStep)
+   : m_ps(std::make_unique<Processing::StreamingAnalyticSignal<float>>(tapCount, timeStep))
+{ }
+
+void Processing::Single::HilbertStream::Push(float sample)
+{
+   m_ps->Push(sample);
+}
+
+void Processing::Single::HilbertStream::PushRange(const Array<float>^ samples, WriteOnlyArray<float>^ amplitudes)
+{
+   if (amplitudes->Length < samples->Length)
+      throw ref new InvalidArgumentException();
+   for (unsigned i = 0; i < samples->Length; ++i) {
+      m_ps->Push(samples[i]);
+      amplitudes[i] = m_ps->GetAmplitude();
+   }
+}
+
+float Processing::Single::HilbertStream::Amplitude::get()
+{
+   return m_ps->GetAmplitude();
+}
+
+float Processing::Single::HilbertStream::Phase::get()
+{
+   return m_ps->GetPhase();
+}
+
+float Processing::Single::HilbertStream::Frequency::get()
+{
+   return m_ps->GetFrequency();
+}
+
+int32 Processing::Single::HilbertStream::Delay::get()
+{
+   return m_ps->GetDelay();
+}
+
+bool Processing::Single::HilbertStream::IsReady::get()
+{
+   return m_ps->IsReady();
+}
+
+Processing::Double::HilbertStream::HilbertStream(int32 tapCount, double timeStep)
+   : m_ps(std::make_unique<Processing::StreamingAnalyticSignal<double>>(tapCount, timeStep))
+{ }
+
+void Processing::Double::HilbertStream::Push(double sample)
+{
+   m_ps->Push(sample);
+}
+
+void Processing::Double::HilbertStream::PushRange(const Array<double>^ samples, WriteOnlyArray<double>^ amplitudes)
+{
+   if (amplitudes->Length < samples->Length)
+      throw ref new InvalidArgumentException();
+   for (unsigned i = 0; i < samples->Length; ++i) {
+      m_ps->Push(samples[i]);
+      amplitudes[i] = m_ps->GetAmplitude();
+   }
+}
+
+double Processing::Double::HilbertStream::Amplitude::get()
+{
+   return m_ps->GetAmplitude();
+}
+
+double Processing::Double::HilbertStream::Phase::get()
+{
+   return m_ps->GetPhase();
+}
+
+double Processing::Double::HilbertStream::Frequency::get()
+{
+   return m_ps->GetFrequency();
+}
+
+int32 Processing::Double::HilbertStream::Delay::get()
+{
+   return m_ps->GetDelay();
+}
+
+bool Processing::Double::HilbertStream::IsReady::get()
+{
+   return m_ps->IsReady();
+}
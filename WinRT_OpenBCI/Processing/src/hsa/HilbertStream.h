@@ -0,0 +1,95 @@
+/*
+*    Copyright 2017 Mikhail Vasilyev
+*
+*    Licensed under the Apache License, Version 2.0 (the "License");
+*    you may not use this file except in compliance with the License.
+*    You may obtain a copy of the License at
+*
+*        http://www.apache.org/licenses/LICENSE-2.0
+*
+*    Unless required by applicable law or agreed to in writing, software
+*    distributed under the License is distributed on an "AS IS" BASIS,
+*    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+*    See the License for the specific language governing permissions and
+*    limitations under the License.
+*/
+#pragma once
+#include <memory>
+#include "Streaming.h"
+
+using namespace Platform;
+
+namespace Processing
+{
+   namespace Single
+   {
+      /// <summary>
+      /// Single-precision per-sample Hilbert analysis using an FIR Hilbert transformer.
+      /// Results lag the input by Delay samples.
+      /// </summary>
+      public ref class HilbertStream sealed
+      {
+         std::unique_ptr<Processing::StreamingAnalyticSignal<float>> m_ps;
+
+      public:
+         /// <summary>
+         /// Creates an empty stream
+         /// </summary>
+         /// <param name="tapCount">FIR length, rounded up to an odd number. Longer filters extend the usable band towards 0 Hz</param>
+         /// <param name="timeStep">Interval between samples</param>
+         HilbertStream(int32 tapCount, float timeStep);
+
+         /// <summary>
+         /// Adds one sample and updates instantaneous attributes, O(tapCount)
+         /// </summary>
+         void Push(float sample);
+
+         /// <summary>
+         /// Adds samples one by one, writing the amplitude envelope after each of them
+         /// </summary>
+         void PushRange(const Array<float>^ samples, WriteOnlyArray<float>^ amplitudes);
+
+         property float Amplitude { float get(); }
+         property float Phase { float get(); }
+         property float Frequency { float get(); }
+         property int32 Delay { int32 get(); }
+         property bool IsReady { bool get(); }
+      };
+   }
+
+   namespace Double
+   {
+      /// <summary>
+      /// Double-precision per-sample Hilbert analysis using an FIR Hilbert transformer.
+      /// Results lag the input by Delay samples.
+      /// </summary>
+      public ref class HilbertStream sealed
+      {
+         std::unique_ptr<Processing::StreamingAnalyticSignal<double>> m_ps;
+
+      public:
+         /// <summary>
+         /// Creates an empty stream
+         /// </summary>
+         /// <param name="tapCount">FIR length, rounded up to an odd number. Longer filters extend the usable band towards 0 Hz</param>
+         /// <param name="timeStep">Interval between samples</param>
+         HilbertStream(int32 tapCount, double timeStep);
+
+         /// <summary>
+         /// Adds one sample and updates instantaneous attributes, O(tapCount)
+         /// </summary>
+         void Push(double sample);
+
+         /// <summary>
+         /// Adds samples one by one, writing the amplitude envelope after each of them
+         /// </summary>
+         void PushRange(const Array<double>^ samples, WriteOnlyArray<double>^ amplitudes);
+
+         property double Amplitude { double get(); }
+         property double Phase { double get(); }
+         property double Frequency { double get(); }
+         property int32 Delay { int32 get(); }
+         property bool IsReady { bool get(); }
+      };
+   }
+}
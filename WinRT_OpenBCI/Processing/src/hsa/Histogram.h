@@ -0,0 +1,146 @@
+/*
+*    Copyright 2017 Mikhail Vasilyev
+*
+*    Licensed under the Apache License, Version 2.0 (the "License");
+*    you may not use this file except in compliance with the License.
+*    You may obtain a copy of the License at
+*
+*        http://www.apache.org/licenses/LICENSE-2.0
+*
+*    Unless required by applicable law or agreed to in writing, software
+*    distributed under the License is distributed on an "AS IS" BASIS,
+*    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+*    See the License for the specific language governing permissions and
+*    limitations under the License.
+*/
+#pragma once
+#include <vector>
+#include <algorithm>
+#include <cassert>
+#include <type_traits>
+
+namespace Processing
+{
+   /// <summary>
+   /// Binned Hilbert spectrum: instantaneous amplitudes accumulated into equally spaced frequency bins.
+   /// Built in a single sweep over time steps and IMFs, instead of one sweep per queried frequency.
+   /// </summary>
+   template <typename TData, typename = std::enable_if_t<std::is_floating_point_v<TData>>>
+   class HilbertHistogram final
+   {
+      const int m_binCount;
+      const int m_length;
+      const TData m_fmin;
+      const TData m_invBinWidth;
+
+      std::vector<TData> m_weights;  // [t], time integration weights
+      std::vector<TData> m_marginal; // [bin]
+      std::vector<TData> m_grid;     // [bin][t], empty unless requested
+
+   public:
+      // length - number of instantaneous frequency values per IMF
+      HilbertHistogram(int binCount, TData fmin, TData fmax, int length, TData timestep, bool keepGrid)
+         : m_binCount(binCount), m_length(length), m_fmin(fmin), m_invBinWidth(binCount / (fmax - fmin)),
+         m_weights(length, timestep * timestep), m_marginal(binCount, (TData)0.0),
+         m_grid(keepGrid ? (size_t)binCount * length : 0, (TData)0.0)
+      {
+         assert(binCount > 0 && fmax > fmin);
+
+         // same trapezoidal weighting as HilbertSpectrumBase::GetMarginalAt
+         if (length > 1) {
+            m_weights.front() *= (TData)0.5;
+            m_weights.back() *= (TData)0.5;
+         }
+         else {
+            std::fill(m_weights.begin(), m_weights.end(), (TData)0.0);
+         }
+      }
+      // Adds one IMF. pampl and pfreq must hold at least GetLength() values.
+      void Accumulate(const TData *pampl, const TData *pfreq)
+      {
+         const bool keepGrid = !m_grid.empty();
+         for (int t = 0; t < m_length; ++t) {
+            TData pos = (pfreq[t] - m_fmin) * m_invBinWidth;
+            if (!(pos >= (TData)0.0 && pos < (TData)m_binCount))
+               continue; // also filters NaNs
+            int bin = (int)pos;
+            m_marginal[bin] += m_weights[t] * pampl[t];
+            if (keepGrid)
+               m_grid[(size_t)bin * m_length + t] += pampl[t];
+         }
+      }
+      int GetBinCount() const noexcept
+      {
+         return m_binCount;
+      }
+      int GetLength() const noexcept
+      {
+         return m_length;
+      }
+      const TData *GetMarginal() const noexcept
+      {
+         return m_marginal.data();
+      }
+      // row-major [bin][t], null if the grid was not requested
+      const TData *GetGrid() const noexcept
+      {
+         return m_grid.empty() ? nullptr : m_grid.data();
+      }
+   };
+
+   /// <summary>
+   /// Counts of instantaneous frequencies over a fixed range, for percentile estimates.
+   /// Counters built over the same range by different workers can be merged.
+   /// </summary>
+   template <typename TData, typename = std::enable_if_t<std::is_floating_point_v<TData>>>
+   class FrequencyCounter final
+   {
+      static constexpr int BINS = 2048;
+
+      TData m_lo, m_hi, m_invBinWidth;
+      std::vector<unsigned> m_counts;
+      unsigned long long m_total;
+
+   public:
+      // values outside [lo, hi) are counted in the first or last bin
+      FrequencyCounter(TData lo, TData hi)
+         : m_lo(lo), m_hi(hi), m_invBinWidth(BINS / (hi - lo)), m_counts(BINS, 0), m_total(0)
+      {
+         assert(hi > lo);
+      }
+      void Add(const TData *pfreq, int count)
+      {
+         for (int i = 0; i < count; ++i) {
+            TData pos = (pfreq[i] - m_lo) * m_invBinWidth;
+            if (pos != pos)
+               continue; // NaN
+            int bin = (int)std::min(std::max(pos, (TData)0.0), (TData)(BINS - 1));
+            m_counts[bin]++;
+            m_total++;
+         }
+      }
+      void Merge(const FrequencyCounter& other)
+      {
+         assert(other.m_lo == m_lo && other.m_hi == m_hi);
+         for (int i = 0; i < BINS; ++i)
+            m_counts[i] += other.m_counts[i];
+         m_total += other.m_total;
+      }
+      // Value below which the given fraction of counts lies, interpolated within a bin
+      TData Percentile(double fraction) const
+      {
+         if (m_total == 0)
+            return m_lo;
+         const double target = std::min(std::max(fraction, 0.0), 1.0) * m_total;
+         double cumulative = 0.0;
+         for (int i = 0; i < BINS; ++i) {
+            if (cumulative + m_counts[i] >= target && m_counts[i] > 0) {
+               double within = (target - cumulative) / m_counts[i];
+               return m_lo + (TData)((i + within) / m_invBinWidth);
+            }
+            cumulative += m_counts[i];
+         }
+         return m_hi;
+      }
+   };
+}
@@ -44,6 +44,19 @@ inline IAsyncOperation<Double::ISpectralAnalysis^>^ Hsa::AnalyseAsync(const Arra
    });
 }
 
+[Windows::Foundation::Metadata::DefaultOverloadAttribute()]
+Double::ISpectralAnalysis ^ Hsa::Analyse(const Array<double>^ yValues, double timeStep, HilbertOptions^ options)
+{
+   return ref new SpectralAnalyzer<double>(yValues, timeStep, options->FrequencyMethod, options->Demodulator);
+}
+[Windows::Foundation::Metadata::DefaultOverloadAttribute()]
+inline IAsyncOperation<Double::ISpectralAnalysis^>^ Hsa::AnalyseAsync(const Array<double>^ yValues, double timeStep, HilbertOptions^ options)
+{
+   return concurrency::create_async([=]() {
+      return Hsa::Analyse(yValues, timeStep, options);
+   });
+}
+
 Double::ISpectralAnalysis ^ Hsa::Analyse(const Array<double>^ yValues, const Array<double>^ xValues)
 {
    return Hsa::Analyse(yValues, MeanStep(xValues));
@@ -66,6 +79,17 @@ inline IAsyncOperation<Single::ISpectralAnalysis^>^ Hsa::AnalyseAsync(const Arra
    });
 }
 
+Single::ISpectralAnalysis ^ Hsa::Analyse(const Array<float>^ yValues, float timeStep, HilbertOptions^ options)
+{
+   return ref new SpectralAnalyzer<float>(yValues, timeStep, options->FrequencyMethod, options->Demodulator);
+}
+inline IAsyncOperation<Single::ISpectralAnalysis^>^ Hsa::AnalyseAsync(const Array<float>^ yValues, float timeStep, HilbertOptions^ options)
+{
+   return concurrency::create_async([=]() {
+      return Hsa::Analyse(yValues, timeStep, options);
+   });
+}
+
 Single::ISpectralAnalysis ^ Hsa::Analyse(const Array<float>^ yValues, const Array<float>^ xValues)
 {
    return ref new SpectralAnalyzer<float>(yValues, MeanStep(xValues));
@@ -102,6 +126,30 @@ inline IAsyncOperation<Single::IHilbertSpectrum^>^ Hsa::GetHilbertSpectrumAsync(
    });
 }
 
+[Windows::Foundation::Metadata::DefaultOverloadAttribute()]
+Double::IHilbertSpectrum ^ Hsa::GetHilbertSpectrum(Double::IImfDecomposition ^ emd, double timestep, HilbertOptions^ options)
+{
+   return ref new HilbertSpectrum<double>(emd->ImfFunctions, timestep, options);
+}
+[Windows::Foundation::Metadata::DefaultOverloadAttribute()]
+inline IAsyncOperation<Double::IHilbertSpectrum^>^ Hsa::GetHilbertSpectrumAsync(Double::IImfDecomposition ^ emd, double timestep, HilbertOptions^ options)
+{
+   return concurrency::create_async([=]() {
+      return Hsa::GetHilbertSpectrum(emd, timestep, options);
+   });
+}
+
+Single::IHilbertSpectrum ^ Hsa::GetHilbertSpectrum(Single::IImfDecomposition ^ emd, float timestep, HilbertOptions^ options)
+{
+   return ref new HilbertSpectrum<float>(emd->ImfFunctions, timestep, options);
+}
+inline IAsyncOperation<Single::IHilbertSpectrum^>^ Hsa::GetHilbertSpectrumAsync(Single::IImfDecomposition ^ emd, float timestep, HilbertOptions^ options)
+{
+   return concurrency::create_async([=]() {
+      return Hsa::GetHilbertSpectrum(emd, timestep, options);
+   });
+}
+
 Double::IHilbertSpectrum ^ Hsa::GetHilbertSpectrum(Double::IImfDecomposition ^ emd, const Array<double>^ xValues)
 {
    return ref new HilbertSpectrum<double>(emd->ImfFunctions, MeanStep(xValues));
@@ -17,6 +17,7 @@
 #include "ISpectralAnalysis.h"
 #include "IImfDecomposition.h"
 #include "IHilbertSpectrum.h"
+#include "HilbertOptions.h"
 
 using namespace Windows::Foundation;
 using namespace Platform;
@@ -60,6 +61,22 @@ namespace Processing
       /// <param name="timeStep">Average interval between data points</param>
       /// <returns>Analysis results</returns>
       static IAsyncOperation<Double::ISpectralAnalysis^>^ AnalyseAsync(const Array<double>^ yValues, double timeStep);
+      /// <summary>
+      /// Double-precision synchronous Hilbert analysis
+      /// </summary>
+      /// <param name="yValues">Data to analyse</param>
+      /// <param name="timeStep">Average interval between data points</param>
+      /// <param name="options">Analysis settings</param>
+      /// <returns>Analysis results</returns>
+      static Double::ISpectralAnalysis^ Analyse(const Array<double>^ yValues, double timeStep, HilbertOptions^ options);
+      /// <summary>
+      /// Double-precision asynchronous Hilbert analysis
+      /// </summary>
+      /// <param name="yValues">Data to analyse</param>
+      /// <param name="timeStep">Average interval between data points</param>
+      /// <param name="options">Analysis settings</param>
+      /// <returns>Analysis results</returns>
+      static IAsyncOperation<Double::ISpectralAnalysis^>^ AnalyseAsync(const Array<double>^ yValues, double timeStep, HilbertOptions^ options);
 
 
       /// <summary>
@@ -91,6 +108,22 @@ namespace Processing
       /// <param name="timeStep">Average interval between data points</param>
       /// <returns>Analysis results</returns>
       static IAsyncOperation<Single::ISpectralAnalysis^>^ AnalyseAsync(const Array<float>^ yValues, float timeStep);
+      /// <summary>
+      /// Single-precision synchronous Hilbert analysis
+      /// </summary>
+      /// <param name="yValues">Data to analyse</param>
+      /// <param name="timeStep">Average interval between data points</param>
+      /// <param name="options">Analysis settings</param>
+      /// <returns>Analysis results</returns>
+      static Single::ISpectralAnalysis^ Analyse(const Array<float>^ yValues, float timeStep, HilbertOptions^ options);
+      /// <summary>
+      /// Single-precision asynchronous Hilbert analysis
+      /// </summary>
+      /// <param name="yValues">Data to analyse</param>
+      /// <param name="timeStep">Average interval between data points</param>
+      /// <param name="options">Analysis settings</param>
+      /// <returns>Analysis results</returns>
+      static IAsyncOperation<Single::ISpectralAnalysis^>^ AnalyseAsync(const Array<float>^ yValues, float timeStep, HilbertOptions^ options);
 
 
       /// <summary>
@@ -127,6 +160,44 @@ namespace Processing
       /// <returns>Hilbert spectrum</returns>
       static IAsyncOperation<Single::IHilbertSpectrum^>^ GetHilbertSpectrumAsync(Single::IImfDecomposition^ emd, float timestep);
 
+      /// <summary>
+      /// Returns an object that can calculate Hilbert Spectrum and Marginal Hilbert Spectrum for a signal
+      /// with the given Intrinsic Mode Functions. Synchronous double-precision calculations.
+      /// </summary>
+      /// <param name="emd">Empirical Mode decomposition of the signal of interest</param>
+      /// <param name="timestep">Mean time step</param>
+      /// <param name="options">Analysis settings</param>
+      /// <returns>Hilbert spectrum</returns>
+      static Double::IHilbertSpectrum^ GetHilbertSpectrum(Double::IImfDecomposition^ emd, double timestep, HilbertOptions^ options);
+      /// <summary>
+      /// Returns an object that can calculate Hilbert Spectrum and Marginal Hilbert Spectrum for a signal
+      /// with the given Intrinsic Mode Functions. Synchronous single-precision calculations.
+      /// </summary>
+      /// <param name="emd">Empirical Mode decomposition of the signal of interest</param>
+      /// <param name="timestep">Mean time step</param>
+      /// <param name="options">Analysis settings</param>
+      /// <returns>Hilbert spectrum</returns>
+      static Single::IHilbertSpectrum^ GetHilbertSpectrum(Single::IImfDecomposition^ emd, float timestep, HilbertOptions^ options);
+
+      /// <summary>
+      /// Returns an object that can calculate Hilbert Spectrum and Marginal Hilbert Spectrum for a signal
+      /// with the given Intrinsic Mode Functions. Asynchronous double-precision calculations.
+      /// </summary>
+      /// <param name="emd">Empirical Mode decomposition of the signal of interest</param>
+      /// <param name="timestep">Mean time step</param>
+      /// <param name="options">Analysis settings</param>
+      /// <returns>Hilbert spectrum</returns>
+      static IAsyncOperation<Double::IHilbertSpectrum^>^ GetHilbertSpectrumAsync(Double::IImfDecomposition^ emd, double timestep, HilbertOptions^ options);
+      /// <summary>
+      /// Returns an object that can calculate Hilbert Spectrum and Marginal Hilbert Spectrum for a signal
+      /// with the given Intrinsic Mode Functions. Asynchronous single-precision calculations.
+      /// </summary>
+      /// <param name="emd">Empirical Mode decomposition of the signal of interest</param>
+      /// <param name="timestep">Mean time step</param>
+      /// <param name="options">Analysis settings</param>
+      /// <returns>Hilbert spectrum</returns>
+      static IAsyncOperation<Single::IHilbertSpectrum^>^ GetHilbertSpectrumAsync(Single::IImfDecomposition^ emd, float timestep, HilbertOptions^ options);
+
       /// <summary>
       /// Returns an object that can calculate Hilbert Spectrum and Marginal Hilbert Spectrum for a signal
       /// with the given Intrinsic Mode Functions. Synchronous double-precision calculations.
@@ -15,6 +15,8 @@
 */
 #pragma once
 
+using namespace Platform;
+
 namespace Processing
 {
    namespace Double
@@ -29,6 +31,20 @@ namespace Processing
          }
          double ComputeAt(double t, double w);
          double ComputeMarginalAt(double w);
+         /// <summary>
+         /// Marginal spectrum for binCount equal frequency bins covering [minFrequency, maxFrequency)
+         /// </summary>
+         Array<double>^ ComputeMarginal(int32 binCount, double minFrequency, double maxFrequency);
+         /// <summary>
+         /// Summed amplitudes per frequency bin and time step, row-major [bin][time step]
+         /// </summary>
+         Array<double>^ ComputeHistogram(int32 binCount, double minFrequency, double maxFrequency);
+         /// <summary>
+         /// Renders the spectrum into image, row-major [height][width] with row 0 at minFrequency.
+         /// Time is measured in time steps. smoothing is the Gaussian radius in pixels, 0 disables it.
+         /// </summary>
+         void Rasterize(double minTime, double maxTime, double minFrequency, double maxFrequency, int32 width, int32 height,
+                        bool logScale, double smoothing, WriteOnlyArray<double>^ image);
       };
    }
    namespace Single
@@ -43,6 +59,20 @@ namespace Processing
          }
          float ComputeAt(float t, float w);
          float ComputeMarginalAt(float w);
+         /// <summary>
+         /// Marginal spectrum for binCount equal frequency bins covering [minFrequency, maxFrequency)
+         /// </summary>
+         Array<float>^ ComputeMarginal(int32 binCount, float minFrequency, float maxFrequency);
+         /// <summary>
+         /// Summed amplitudes per frequency bin and time step, row-major [bin][time step]
+         /// </summary>
+         Array<float>^ ComputeHistogram(int32 binCount, float minFrequency, float maxFrequency);
+         /// <summary>
+         /// Renders the spectrum into image, row-major [height][width] with row 0 at minFrequency.
+         /// Time is measured in time steps. smoothing is the Gaussian radius in pixels, 0 disables it.
+         /// </summary>
+         void Rasterize(float minTime, float maxTime, float minFrequency, float maxFrequency, int32 width, int32 height,
+                        bool logScale, float smoothing, WriteOnlyArray<float>^ image);
       };
    }
 }
\ No newline at end of file
@@ -0,0 +1,260 @@
+/*
+*    Copyright 2017 Mikhail Vasilyev
+*
+*    Licensed under the Apache License, Version 2.0 (the "License");
+*    you may not use this file except in compliance with the License.
+*    You may obtain a copy of the License at
+*
+*        http://www.apache.org/licenses/LICENSE-2.0
+*
+*    Unless required by applicable law or agreed to in writing, software
+*    distributed under the License is distributed on an "AS IS" BASIS,
+*    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+*    See the License for the specific language governing permissions and
+*    limitations under the License.
+*/
+#pragma once
+#include <complex>
+#include <vector>
+#include <cassert>
+#include <limits>
+#include <algorithm>
+#include <type_traits>
+#include "../simd/Simd.h"
+
+namespace Processing
+{
+#pragma region Instantaneous attributes
+
+   // Fused amplitude/phase/frequency computation over an analytic signal.
+   // The frequency sign follows HilbertTransform: (phase[i-1] - phase[i]) / dt.
+   template <typename TData, typename = std::enable_if_t<std::is_floating_point_v<TData>>>
+   class InstAttributesKernel final
+   {
+      typedef Pack<TData> P;
+      typedef std::complex<TData> Cval;
+
+      static constexpr int W = P::Width;
+
+      struct State
+      {
+         P prevPhase;     // last lane = wrapped phase at i-1
+         P prevUnwrapped; // broadcast unwrapped phase at i-1
+      };
+
+   public:
+      InstAttributesKernel() = delete;
+
+      // pampl and pphase receive n values, pfreq receives n-1 values; any of them may be null.
+      // Phases are unwrapped. If derivative is true, frequency is computed as Im(conj(z)*dz)/|z|^2
+      // at the mid-point between samples, without evaluating arctangents.
+      // pminFreq and pmaxFreq, if not null, receive the range of the n-1 frequencies (requires pfreq).
+      static void Compute(const Cval *pz, int n, TData timestep, bool derivative,
+                          TData *pampl, TData *pphase, TData *pfreq,
+                          TData *pminFreq = nullptr, TData *pmaxFreq = nullptr)
+      {
+         assert(n > 0);
+         const bool needPhase = pphase != nullptr || (pfreq != nullptr && !derivative);
+         const TData negInvDt = (TData)-1.0 / timestep;
+
+         const TData phase0 = Atan2(P(pz[0].imag()), P(pz[0].real())).Last();
+         if (pampl)
+            pampl[0] = std::sqrt(pz[0].real() * pz[0].real() + pz[0].imag() * pz[0].imag());
+         if (pphase)
+            pphase[0] = phase0;
+
+         State s = { P(phase0), P(phase0) };
+         const bool needRange = pfreq != nullptr && (pminFreq != nullptr || pmaxFreq != nullptr);
+         P fmin(std::numeric_limits<TData>::max()), fmax(std::numeric_limits<TData>::lowest());
+
+         int i = 1;
+         for (; i + W <= n; i += W) {
+            Block(pz + i, needPhase, derivative, negInvDt, s,
+                  pampl ? pampl + i : nullptr, pphase ? pphase + i : nullptr, pfreq ? pfreq + i - 1 : nullptr);
+            if (needRange) {
+               P f = P::Load(pfreq + i - 1); // still in L1
+               fmin = Min(fmin, f);
+               fmax = Max(fmax, f);
+            }
+         }
+         TData minFreq = fmin.MinLane(), maxFreq = fmax.MaxLane();
+         if (i < n) {
+            // pad the tail to a full block, pz[-1] must stay valid for the derivative form
+            const int count = n - i;
+            Cval ztail[W + 1];
+            TData ampl[W], phase[W], freq[W];
+
+            for (int j = 0; j <= W; ++j)
+               ztail[j] = pz[std::min(i - 1 + j, n - 1)];
+
+            Block(ztail + 1, needPhase, derivative, negInvDt, s,
+                  pampl ? ampl : nullptr, pphase ? phase : nullptr, pfreq ? freq : nullptr);
+
+            if (pampl)
+               std::copy(ampl, ampl + count, pampl + i);
+            if (pphase)
+               std::copy(phase, phase + count, pphase + i);
+            if (pfreq)
+               std::copy(freq, freq + count, pfreq + i - 1);
+            if (needRange) {
+               // only the real lanes, padding would add spurious zeros
+               minFreq = std::min(minFreq, *std::min_element(freq, freq + count));
+               maxFreq = std::max(maxFreq, *std::max_element(freq, freq + count));
+            }
+         }
+         if (n < 2)
+            minFreq = maxFreq = (TData)0.0;
+         if (needRange && pminFreq)
+            *pminFreq = minFreq;
+         if (needRange && pmaxFreq)
+            *pmaxFreq = maxFreq;
+      }
+
+   private:
+      static void Block(const Cval *pz, bool needPhase, bool derivative, TData negInvDt, State& s,
+                        TData *pampl, TData *pphase, TData *pfreq)
+      {
+         const TData twoPi = (TData)6.28318530717958648;
+
+         P re, im;
+         P::LoadComplex(pz, &re, &im);
+
+         if (pampl)
+            Sqrt(re * re + im * im).Store(pampl);
+
+         if (needPhase) {
+            P phase = Atan2(im, re);
+            P dphase = WrapAngle(phase - P::ShiftIn(s.prevPhase, phase));
+            s.prevPhase = phase;
+
+            if (pphase) {
+               // running sum of wrapped differences, snapped back onto the exact branch to stop drift
+               P unwrapped = s.prevUnwrapped + dphase.PrefixSum();
+               unwrapped = phase + P(twoPi) * Round((unwrapped - phase) * P((TData)1.0 / twoPi));
+               unwrapped.Store(pphase);
+               s.prevUnwrapped = P(unwrapped.Last());
+            }
+            if (pfreq && !derivative)
+               (dphase * P(negInvDt)).Store(pfreq);
+         }
+
+         if (pfreq && derivative) {
+            P pre, pim;
+            P::LoadComplex(pz - 1, &pre, &pim);
+
+            P num = pre * im - pim * re; // Im(conj(z[i-1]) * z[i])
+            P sre = pre + re;
+            P sim = pim + im;
+            P den = sre * sre + sim * sim; // |z[i-1] + z[i]|^2 = 4|z_mid|^2
+            P freq = P((TData)4.0 * negInvDt) * num / Max(den, P(std::numeric_limits<TData>::min()));
+            Select(den > P((TData)0.0), freq, P((TData)0.0)).Store(pfreq);
+         }
+      }
+   };
+
+#pragma endregion
+
+#pragma region Energy operator demodulation
+
+   // DESA-2 (Maragos, Kaiser, Quatieri) on a real signal, from the Teager-Kaiser energy operator
+   // Psi[x](n) = x(n)^2 - x(n-1)x(n+1) applied to x and to y(n) = x(n+1) - x(n-1):
+   //    w = acos(1 - Psi[y] / (2 Psi[x])) / 2,   |a| = 2 Psi[x] / sqrt(Psi[y])
+   // Needs 5 consecutive samples per estimate and no transform, valid for w < pi/2 rad per sample.
+   template <typename TData, typename = std::enable_if_t<std::is_floating_point_v<TData>>>
+   class TeagerKaiserKernel final
+   {
+      typedef Pack<TData> P;
+
+      static constexpr int W = P::Width;
+
+   public:
+      TeagerKaiserKernel() = delete;
+
+      // Same output layout and sign conventions as InstAttributesKernel::Compute. Estimates for the two samples
+      // at each end are copied from their nearest neighbour, phase is the integral of frequency starting at 0.
+      static void Compute(const TData *px, int n, TData timestep, TData *pampl, TData *pphase, TData *pfreq,
+                          TData *pminFreq = nullptr, TData *pmaxFreq = nullptr)
+      {
+         assert(n > 0);
+         std::vector<TData> omega(n + W), ampl(n + W);
+
+         if (n < 5) {
+            for (int i = 0; i < n; ++i) {
+               omega[i] = (TData)0.0;
+               ampl[i] = std::abs(px[i]);
+            }
+         }
+         else {
+            int i = 2;
+            for (; i + W <= n - 2; i += W)
+               Block(px + i, &omega[i], &ampl[i]);
+            if (i < n - 2) {
+               // pad the tail to a full block by repeating the last samples
+               TData xtail[W + 4];
+               for (int j = 0; j < W + 4; ++j)
+                  xtail[j] = px[std::min(i - 2 + j, n - 1)];
+               TData otail[W], atail[W];
+               Block(xtail + 2, otail, atail);
+               std::copy(otail, otail + (n - 2 - i), &omega[i]);
+               std::copy(atail, atail + (n - 2 - i), &ampl[i]);
+            }
+            omega[0] = omega[1] = omega[2];
+            ampl[0] = ampl[1] = ampl[2];
+            omega[n - 1] = omega[n - 2] = omega[n - 3];
+            ampl[n - 1] = ampl[n - 2] = ampl[n - 3];
+         }
+
+         if (pampl)
+            std::copy(ampl.begin(), ampl.begin() + n, pampl);
+
+         // frequency between samples i and i+1, like the phase difference estimator
+         const TData invDt = (TData)1.0 / timestep;
+         TData minFreq = std::numeric_limits<TData>::max(), maxFreq = std::numeric_limits<TData>::lowest();
+         TData phase = 0;
+         if (pphase)
+            pphase[0] = phase;
+         for (int i = 0; i < n - 1; ++i) {
+            TData freq = (TData)0.5 * (omega[i] + omega[i + 1]) * invDt;
+            if (pfreq)
+               pfreq[i] = freq;
+            if (pphase)
+               pphase[i + 1] = (phase -= freq * timestep);
+            minFreq = std::min(minFreq, freq);
+            maxFreq = std::max(maxFreq, freq);
+         }
+         if (n < 2)
+            minFreq = maxFreq = (TData)0.0;
+         if (pminFreq)
+            *pminFreq = minFreq;
+         if (pmaxFreq)
+            *pmaxFreq = maxFreq;
+      }
+
+   private:
+      // W estimates centred at px[0..W-1], reads px[-2..W+1]
+      static void Block(const TData *px, TData *pomega, TData *pampl)
+      {
+         const P xm2 = P::Load(px - 2), xm1 = P::Load(px - 1), x0 = P::Load(px);
+         const P xp1 = P::Load(px + 1), xp2 = P::Load(px + 2);
+
+         const P psiX = x0 * x0 - xm1 * xp1;
+         const P ym1 = x0 - xm2, y0 = xp1 - xm1, yp1 = xp2 - x0;
+         const P psiY = y0 * y0 - ym1 * yp1;
+
+         const P tiny(std::numeric_limits<TData>::min());
+         const P zero((TData)0.0), one((TData)1.0);
+         const auto valid = Min(psiX, psiY) > tiny;
+
+         // acos(c) = atan2(sqrt(1 - c^2), c)
+         P c = one - psiY / (P((TData)2.0) * Max(psiX, tiny));
+         c = Max(Min(c, one), P((TData)-1.0));
+         P omega = P((TData)0.5) * Atan2(Sqrt(one - c * c), c);
+         P ampl = P((TData)2.0) * psiX / Sqrt(Max(psiY, tiny));
+
+         Select(valid, omega, zero).Store(pomega);
+         Select(valid, ampl, Abs(x0)).Store(pampl);
+      }
+   };
+
+#pragma endregion
+}
@@ -0,0 +1,166 @@
+/*
+*    Copyright 2017 Mikhail Vasilyev
+*
+*    Licensed under the Apache License, Version 2.0 (the "License");
+*    you may not use this file except in compliance with the License.
+*    You may obtain a copy of the License at
+*
+*        http://www.apache.org/licenses/LICENSE-2.0
+*
+*    Unless required by applicable law or agreed to in writing, software
+*    distributed under the License is distributed on an "AS IS" BASIS,
+*    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+*    See the License for the specific language governing permissions and
+*    limitations under the License.
+*/
+#pragma once
+#include <vector>
+#include <cmath>
+#include <cassert>
+#include <algorithm>
+#include <type_traits>
+
+namespace Processing
+{
+   /// <summary>
+   /// Renders the Hilbert spectrum H(t, w) into an image, one tile per task.
+   /// Tiles are accumulated with a halo wide enough for the Gaussian kernel, so smoothing
+   /// and log scaling happen in the same pass without seams between tiles.
+   /// </summary>
+   template <typename TData, typename = std::enable_if_t<std::is_floating_point_v<TData>>>
+   class HilbertRasterizer final
+   {
+      static constexpr int TILE = 64;
+
+      std::vector<const TData *> m_ampl; // [imf] -> amplitudes
+      std::vector<const TData *> m_freq; // [imf] -> frequencies
+      const int m_length;                // samples per IMF
+
+   public:
+      HilbertRasterizer(std::vector<const TData *> ampl, std::vector<const TData *> freq, int length)
+         : m_ampl(std::move(ampl)), m_freq(std::move(freq)), m_length(length)
+      {
+         assert(m_ampl.size() == m_freq.size());
+      }
+      // Fills pimage row-major [height][width]; row 0 is fmin, column 0 is tmin.
+      // t is measured in time steps. Each pixel holds the mean over its time span of the
+      // summed amplitudes of all IMFs whose frequency falls into the pixel's frequency span.
+      // sigma is the Gaussian smoothing radius in pixels, 0 disables smoothing.
+      void Render(TData tmin, TData tmax, TData fmin, TData fmax, int width, int height,
+                  bool logScale, TData sigma, TData *pimage) const
+      {
+         assert(width > 0 && height > 0 && tmax > tmin && fmax > fmin);
+
+         // sample range of each column, shared by all tiles
+         std::vector<int> colFirst(width), colLast(width);
+         const TData tstep = (tmax - tmin) / width;
+         for (int x = 0; x < width; ++x) {
+            TData t0 = tmin + x * tstep;
+            int first = (int)std::ceil(t0);
+            int last = (int)std::ceil(t0 + tstep);
+            if (last <= first) { // zoomed in beyond sample resolution
+               first = (int)std::floor(t0 + (TData)0.5 * tstep);
+               last = first + 1;
+            }
+            colFirst[x] = std::max(first, 0);
+            colLast[x] = std::min(last, m_length);
+         }
+
+         std::vector<TData> kernel = GaussianKernel(sigma);
+         const int radius = (int)kernel.size() / 2;
+         const int tilesX = (width + TILE - 1) / TILE;
+         const int tilesY = (height + TILE - 1) / TILE;
+         const TData rowScale = height / (fmax - fmin);
+
+         concurrency::parallel_for(0, tilesX * tilesY, [&, this](int tile) {
+            const int x0 = (tile % tilesX) * TILE, x1 = std::min(x0 + TILE, width);
+            const int y0 = (tile / tilesX) * TILE, y1 = std::min(y0 + TILE, height);
+
+            // tile plus halo, clipped to the image
+            const int ex0 = std::max(x0 - radius, 0), ex1 = std::min(x1 + radius, width);
+            const int ey0 = std::max(y0 - radius, 0), ey1 = std::min(y1 + radius, height);
+            const int ew = ex1 - ex0, eh = ey1 - ey0;
+
+            std::vector<TData> buf((size_t)ew * eh, (TData)0.0);
+            for (int x = ex0; x < ex1; ++x) {
+               const int count = colLast[x] - colFirst[x];
+               if (count <= 0)
+                  continue;
+               const TData norm = (TData)1.0 / count;
+
+               for (size_t imf = 0; imf < m_ampl.size(); ++imf) {
+                  const TData *pa = m_ampl[imf];
+                  const TData *pf = m_freq[imf];
+                  for (int t = colFirst[x]; t < colLast[x]; ++t) {
+                     TData pos = (pf[t] - fmin) * rowScale;
+                     if (!(pos >= (TData)ey0 && pos < (TData)ey1))
+                        continue;
+                     buf[((int)pos - ey0) * ew + (x - ex0)] += pa[t] * norm;
+                  }
+               }
+            }
+
+            if (radius > 0)
+               Smooth(&buf, ew, eh, ex0, ey0, width, height, kernel);
+
+            for (int y = y0; y < y1; ++y) {
+               const TData *psrc = &buf[(y - ey0) * ew + (x0 - ex0)];
+               TData *pdest = pimage + (size_t)y * width + x0;
+               for (int x = 0; x < x1 - x0; ++x)
+                  pdest[x] = logScale ? std::log1p(std::max(psrc[x], (TData)0.0)) : psrc[x];
+            }
+         });
+      }
+
+   private:
+      static std::vector<TData> GaussianKernel(TData sigma)
+      {
+         if (!(sigma > (TData)0.0))
+            return std::vector<TData>(1, (TData)1.0);
+
+         const int radius = std::max(1, (int)std::ceil(3 * sigma));
+         std::vector<TData> kernel(2 * radius + 1);
+         for (int i = -radius; i <= radius; ++i)
+            kernel[i + radius] = std::exp(-(TData)(i * i) / (2 * sigma * sigma));
+         return kernel;
+      }
+      // Separable blur of the extended tile. At the image border the kernel is cut off and
+      // renormalized, everywhere else the halo provides the true neighbours.
+      static void Smooth(std::vector<TData> *pbuf, int ew, int eh, int ex0, int ey0, int width, int height,
+                         const std::vector<TData>& kernel)
+      {
+         const int radius = (int)kernel.size() / 2;
+         std::vector<TData>& buf = *pbuf;
+         std::vector<TData> tmp(buf.size());
+
+         for (int y = 0; y < eh; ++y) {
+            for (int x = 0; x < ew; ++x) {
+               TData sum = 0, wsum = 0;
+               for (int k = -radius; k <= radius; ++k) {
+                  int xx = x + k;
+                  if (ex0 + xx < 0 || ex0 + xx >= width)
+                     continue;
+                  wsum += kernel[k + radius];
+                  if (xx >= 0 && xx < ew)
+                     sum += kernel[k + radius] * buf[y * ew + xx];
+               }
+               tmp[y * ew + x] = sum / wsum;
+            }
+         }
+         for (int y = 0; y < eh; ++y) {
+            for (int x = 0; x < ew; ++x) {
+               TData sum = 0, wsum = 0;
+               for (int k = -radius; k <= radius; ++k) {
+                  int yy = y + k;
+                  if (ey0 + yy < 0 || ey0 + yy >= height)
+                     continue;
+                  wsum += kernel[k + radius];
+                  if (yy >= 0 && yy < eh)
+                     sum += kernel[k + radius] * tmp[yy * ew + x];
+               }
+               buf[y * ew + x] = sum / wsum;
+            }
+         }
+      }
+   };
+}
@@ -0,0 +1,179 @@
+/*
+*    Copyright 2017 Mikhail Vasilyev
+*
+*    Licensed under the Apache License, Version 2.0 (the "License");
+*    you may not use this file except in compliance with the License.
+*    You may obtain a copy of the License at
+*
+*        http://www.apache.org/licenses/LICENSE-2.0
+*
+*    Unless required by applicable law or agreed to in writing, software
+*    distributed under the License is distributed on an "AS IS" BASIS,
+*    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+*    See the License for the specific language governing permissions and
+*    limitations under the License.
+*/
+#pragma once
+#include <vector>
+#include <cmath>
+#include <cassert>
+#include <algorithm>
+#include <type_traits>
+#include "../simd/Simd.h"
+
+namespace Processing
+{
+   /// <summary>
+   /// Sliding DFT over the last windowLength samples of several channels, for a fixed set of bins.
+   /// Each sample costs O(bins) per channel. The recursive state is recomputed exactly from the
+   /// sample history every resyncInterval samples, so rounding errors cannot accumulate.
+   /// </summary>
+   template <typename TData, typename = std::enable_if_t<std::is_floating_point_v<TData>>>
+   class SlidingDftBank final
+   {
+      typedef Pack<TData> P;
+
+      struct Channel
+      {
+         std::vector<TData> history; // ring buffer, windowLength samples
+         std::vector<TData> re, im;  // [bin], padded to a whole number of packs
+         int pos;
+         int sinceResync;
+         long long count;
+      };
+
+      const int m_windowLength;
+      const int m_resyncInterval;
+      const int m_binCount;
+      const int m_paddedCount;
+      std::vector<int> m_bins;      // DFT indices k
+      std::vector<TData> m_cos;     // [bin], cos(2*pi*k/N), padded
+      std::vector<TData> m_sin;     // [bin], sin(2*pi*k/N), padded
+      std::vector<Channel> m_channels;
+
+   public:
+      // bins - DFT indices in [0, windowLength / 2]; resyncInterval <= 0 means once per window
+      SlidingDftBank(int channelCount, int windowLength, std::vector<int> bins, int resyncInterval = 0)
+         : m_windowLength(windowLength), m_resyncInterval(resyncInterval > 0 ? resyncInterval : windowLength),
+         m_binCount((int)bins.size()), m_paddedCount(((int)bins.size() + P::Width - 1) / P::Width * P::Width),
+         m_bins(std::move(bins)), m_cos(m_paddedCount, (TData)0.0), m_sin(m_paddedCount, (TData)0.0),
+         m_channels(channelCount)
+      {
+         assert(channelCount > 0 && windowLength > 0);
+         const double pi = 3.14159265358979324;
+
+         for (int b = 0; b < m_binCount; ++b) {
+            assert(m_bins[b] >= 0 && m_bins[b] <= windowLength / 2);
+            double w = 2 * pi * m_bins[b] / windowLength;
+            m_cos[b] = (TData)std::cos(w);
+            m_sin[b] = (TData)std::sin(w);
+         }
+         for (Channel& ch : m_channels) {
+            ch.history.assign(windowLength, (TData)0.0);
+            ch.re.assign(m_paddedCount, (TData)0.0);
+            ch.im.assign(m_paddedCount, (TData)0.0);
+            ch.pos = 0;
+            ch.sinceResync = 0;
+            ch.count = 0;
+         }
+      }
+      int GetChannelCount() const noexcept
+      {
+         return (int)m_channels.size();
+      }
+      int GetBinCount() const noexcept
+      {
+         return m_binCount;
+      }
+      int GetWindowLength() const noexcept
+      {
+         return m_windowLength;
+      }
+      int GetBin(int index) const
+      {
+         return m_bins[index];
+      }
+      // true once the window of this channel has been filled with real samples
+      bool IsReady(int channel) const
+      {
+         return m_channels[channel].count >= m_windowLength;
+      }
+      // One sample for every channel
+      void PushFrame(const TData *pframe)
+      {
+         for (int c = 0; c < (int)m_channels.size(); ++c)
+            Push(c, pframe[c]);
+      }
+      void Push(int channel, const TData *psamples, int count)
+      {
+         for (int i = 0; i < count; ++i)
+            Push(channel, psamples[i]);
+      }
+      // X_k[n] = e^(i*w_k) * (X_k[n-1] + x[n] - x[n-N])
+      void Push(int channel, TData sample)
+      {
+         Channel& ch = m_channels[channel];
+         const P delta(sample - ch.history[ch.pos]);
+         ch.history[ch.pos] = sample;
+         ch.pos = (ch.pos + 1) % m_windowLength;
+         ch.count++;
+
+         if (++ch.sinceResync >= m_resyncInterval) {
+            Resync(&ch);
+            return;
+         }
+         for (int b = 0; b < m_paddedCount; b += P::Width) {
+            P re = P::Load(&ch.re[b]) + delta;
+            P im = P::Load(&ch.im[b]);
+            P c = P::Load(&m_cos[b]);
+            P s = P::Load(&m_sin[b]);
+            (re * c - im * s).Store(&ch.re[b]);
+            (re * s + im * c).Store(&ch.im[b]);
+         }
+      }
+      // Amplitude of a sinusoid at each bin frequency: 2|X_k|/N, or |X_0|/N for the DC bin
+      void GetAmplitudes(int channel, TData *pout) const
+      {
+         const Channel& ch = m_channels[channel];
+         const TData scale = (TData)2.0 / m_windowLength;
+         for (int b = 0; b < m_binCount; ++b) {
+            TData a = std::sqrt(ch.re[b] * ch.re[b] + ch.im[b] * ch.im[b]) * scale;
+            pout[b] = m_bins[b] == 0 || 2 * m_bins[b] == m_windowLength ? a * (TData)0.5 : a;
+         }
+      }
+      // Periodogram |X_k|^2 / N
+      void GetPowers(int channel, TData *pout) const
+      {
+         const Channel& ch = m_channels[channel];
+         for (int b = 0; b < m_binCount; ++b)
+            pout[b] = (ch.re[b] * ch.re[b] + ch.im[b] * ch.im[b]) / m_windowLength;
+      }
+
+   private:
+      // X_k[n] = sum(j = 0..N-1) x[n-j] * e^(i*w_k*(j+1)), summed in double precision
+      void Resync(Channel *pch) const
+      {
+         const double pi = 3.14159265358979324;
+         Channel& ch = *pch;
+         const int N = m_windowLength;
+
+         for (int b = 0; b < m_binCount; ++b) {
+            const double w = 2 * pi * m_bins[b] / N;
+            const double c = std::cos(w), s = std::sin(w);
+            double re = 0.0, im = 0.0;
+            double pr = c, pim = s; // e^(i*w*(j+1)), rotated in double precision
+            for (int j = 0; j < N; ++j) {
+               double x = ch.history[(ch.pos - 1 - j + N) % N];
+               re += x * pr;
+               im += x * pim;
+               double t = pr * c - pim * s;
+               pim = pr * s + pim * c;
+               pr = t;
+            }
+            ch.re[b] = (TData)re;
+            ch.im[b] = (TData)im;
+         }
+         ch.sinceResync = 0;
+      }
+   };
+}
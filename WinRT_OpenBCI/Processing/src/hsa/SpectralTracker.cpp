@@ -0,0 +1,141 @@
+/*
+*    Copyright 2017 Mikhail Vasilyev
+*
+*    Licensed under the Apache License, Version 2.0 (the "License");
+*    you may not use this file except in compliance with the License.
+*    You may obtain a copy of the License at
+*
+*        http://www.apache.org/licenses/LICENSE-2.0
+*
+*    Unless required by applicable law or agreed to in writing, software
+*    distributed under the License is distributed on an "AS IS" BASIS,
+*    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+*    See the License for the specific language governing permissions and
+*    limitations under the License.
+*/
+#include "pch.h"
+#include <vector>
+#include <cmath>
+#include "SpectralTracker.h"
+
+using namespace Platform;
+
+template<typename TData, typename = std::enable_if_t<std::is_floating_point_v<TData>>>
+inline std::vector<int> FrequenciesToBins(const Array<TData>^ frequencies, int windowLength, TData timeStep)
+{
+   const double scale = windowLength * (double)timeStep / (2 * 3.14159265358979324);
+   std::vector<int> bins(frequencies->Length);
+   for (uint32 i = 0; i < frequencies->Length; ++i) {
+      int k = (int)std::lround(frequencies[i] * scale);
+      if (k < 0 || k > windowLength / 2)
+         throw ref new InvalidArgumentException();
+      bins[i] = k;
+   }
+   return bins;
+}
+
+#pragma region Single
+
+Processing::Single::SpectralTracker::SpectralTracker(int32 channelCount, int32 windowLength, float timeStep,
+                                                     const Array<float>^ frequencies)
+   : m_timeStep(timeStep)
+{
+   if (channelCount <= 0 || windowLength <= 0 || !(timeStep > 0.0f))
+      throw ref new InvalidArgumentException();
+   m_pb = std::make_unique<Processing::SlidingDftBank<float>>(
+      channelCount, windowLength, FrequenciesToBins(frequencies, windowLength, timeStep));
+}
+
+void Processing::Single::SpectralTracker::PushFrame(const Array<float>^ frame)
+{
+   if ((int)frame->Length < m_pb->GetChannelCount())
+      throw ref new InvalidArgumentException();
+   m_pb->PushFrame(frame->Data);
+}
+
+void Processing::Single::SpectralTracker::PushRange(int32 channel, const Array<float>^ samples)
+{
+   if (channel < 0 || channel >= m_pb->GetChannelCount())
+      throw ref new InvalidArgumentException();
+   m_pb->Push(channel, samples->Data, (int)samples->Length);
+}
+
+void Processing::Single::SpectralTracker::GetAmplitudes(int32 channel, WriteOnlyArray<float>^ amplitudes)
+{
+   if (channel < 0 || channel >= m_pb->GetChannelCount() || (int)amplitudes->Length < m_pb->GetBinCount())
+      throw ref new InvalidArgumentException();
+   m_pb->GetAmplitudes(channel, amplitudes->Data);
+}
+
+void Processing::Single::SpectralTracker::GetFrequencies(WriteOnlyArray<float>^ frequencies)
+{
+   if ((int)frequencies->Length < m_pb->GetBinCount())
+      throw ref new InvalidArgumentException();
+   const float scale = 2 * 3.14159265f / (m_pb->GetWindowLength() * m_timeStep);
+   for (int i = 0; i < m_pb->GetBinCount(); ++i)
+      frequencies[i] = m_pb->GetBin(i) * scale;
+}
+
+bool Processing::Single::SpectralTracker::IsReady::get()
+{
+   for (int c = 0; c < m_pb->GetChannelCount(); ++c) {
+      if (!m_pb->IsReady(c))
+         return false;
+   }
+   return true;
+}
+
+#pragma endregion
+
+#pragma region Double
+
+Processing::Double::SpectralTracker::SpectralTracker(int32 channelCount, int32 windowLength, double timeStep,
+                                                     const Array<double>^ frequencies)
+   : m_timeStep(timeStep)
+{
+   if (channelCount <= 0 || windowLength <= 0 || !(timeStep > 0.0))
+      throw ref new InvalidArgumentException();
+   m_pb = std::make_unique<Processing::SlidingDftBank<double>>(
+      channelCount, windowLength, FrequenciesToBins(frequencies, windowLength, timeStep));
+}
+
+void Processing::Double::SpectralTracker::PushFrame(const Array<double>^ frame)
+{
+   if ((int)frame->Length < m_pb->GetChannelCount())
+      throw ref new InvalidArgumentException();
+   m_pb->PushFrame(frame->Data);
+}
+
+void Processing::Double::SpectralTracker::PushRange(int32 channel, const Array<double>^ samples)
+{
+   if (channel < 0 || channel >= m_pb->GetChannelCount())
+      throw ref new InvalidArgumentException();
+   m_pb->Push(channel, samples->Data, (int)samples->Length);
+}
+
+void Processing::Double::SpectralTracker::GetAmplitudes(int32 channel, WriteOnlyArray<double>^ amplitudes)
+{
+   if (channel < 0 || channel >= m_pb->GetChannelCount() || (int)amplitudes->Length < m_pb->GetBinCount())
+      throw ref new InvalidArgumentException();
+   m_pb->GetAmplitudes(channel, amplitudes->Data);
+}
+
+void Processing::Double::SpectralTracker::GetFrequencies(WriteOnlyArray<double>^ frequencies)
+{
+   if ((int)frequencies->Length < m_pb->GetBinCount())
+      throw ref new InvalidArgumentException();
+   const double scale = 2 * 3.14159265358979324 / (m_pb->GetWindowLength() * m_timeStep);
+   for (int i = 0; i < m_pb->GetBinCount(); ++i)
+      frequencies[i] = m_pb->GetBin(i) * scale;
+}
+
+bool Processing::Double::SpectralTracker::IsReady::get()
+{
+   for (int c = 0; c < m_pb->GetChannelCount(); ++c) {
+      if (!m_pb->IsReady(c))
+         return false;
+   }
+   return true;
+}
+
+#pragma endregion
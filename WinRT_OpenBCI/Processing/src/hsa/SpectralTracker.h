@@ -0,0 +1,123 @@
+/*
+*    Copyright 2017 Mikhail Vasilyev
+*
+*    Licensed under the Apache License, Version 2.0 (the "License");
+*    you may not use this file except in compliance with the License.
+*    You may obtain a copy of the License at
+*
+*        http://www.apache.org/licenses/LICENSE-2.0
+*
+*    Unless required by applicable law or agreed to in writing, software
+*    distributed under the License is distributed on an "AS IS" BASIS,
+*    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+*    See the License for the specific language governing permissions and
+*    limitations under the License.
+*/
+#pragma once
+#include <memory>
+#include "SlidingDft.h"
+
+using namespace Platform;
+
+namespace Processing
+{
+   namespace Single
+   {
+      /// <summary>
+      /// Single-precision running spectra of several channels at a few chosen frequencies (sliding DFT).
+      /// Frequencies are in the same units as IHilbertSpectrum, radians per time unit.
+      /// </summary>
+      public ref class SpectralTracker sealed
+      {
+         std::unique_ptr<Processing::SlidingDftBank<float>> m_pb;
+
+      public:
+         /// <summary>
+         /// Creates a tracker with all channels initially silent
+         /// </summary>
+         /// <param name="channelCount">Number of channels</param>
+         /// <param name="windowLength">Number of most recent samples the spectra describe</param>
+         /// <param name="timeStep">Interval between samples</param>
+         /// <param name="frequencies">Frequencies of interest, each rounded to the nearest DFT bin</param>
+         SpectralTracker(int32 channelCount, int32 windowLength, float timeStep, const Array<float>^ frequencies);
+
+         /// <summary>
+         /// Adds one sample to every channel, O(frequencies) per channel
+         /// </summary>
+         void PushFrame(const Array<float>^ frame);
+
+         /// <summary>
+         /// Adds consecutive samples to one channel
+         /// </summary>
+         void PushRange(int32 channel, const Array<float>^ samples);
+
+         /// <summary>
+         /// Amplitudes of the tracked frequencies over the current window of a channel
+         /// </summary>
+         void GetAmplitudes(int32 channel, WriteOnlyArray<float>^ amplitudes);
+
+         /// <summary>
+         /// Frequencies of the DFT bins actually tracked
+         /// </summary>
+         void GetFrequencies(WriteOnlyArray<float>^ frequencies);
+
+         /// <summary>
+         /// True once every channel has received at least windowLength samples
+         /// </summary>
+         property bool IsReady { bool get(); }
+
+      private:
+         float m_timeStep;
+      };
+   }
+
+   namespace Double
+   {
+      /// <summary>
+      /// Double-precision running spectra of several channels at a few chosen frequencies (sliding DFT).
+      /// Frequencies are in the same units as IHilbertSpectrum, radians per time unit.
+      /// </summary>
+      public ref class SpectralTracker sealed
+      {
+         std::unique_ptr<Processing::SlidingDftBank<double>> m_pb;
+
+      public:
+         /// <summary>
+         /// Creates a tracker with all channels initially silent
+         /// </summary>
+         /// <param name="channelCount">Number of channels</param>
+         /// <param name="windowLength">Number of most recent samples the spectra describe</param>
+         /// <param name="timeStep">Interval between samples</param>
+         /// <param name="frequencies">Frequencies of interest, each rounded to the nearest DFT bin</param>
+         SpectralTracker(int32 channelCount, int32 windowLength, double timeStep, const Array<double>^ frequencies);
+
+         /// <summary>
+         /// Adds one sample to every channel, O(frequencies) per channel
+         /// </summary>
+         void PushFrame(const Array<double>^ frame);
+
+         /// <summary>
+         /// Adds consecutive samples to one channel
+         /// </summary>
+         void PushRange(int32 channel, const Array<double>^ samples);
+
+         /// <summary>
+         /// Amplitudes of the tracked frequencies over the current window of a channel
+         /// </summary>
+         void GetAmplitudes(int32 channel, WriteOnlyArray<double>^ amplitudes);
+
+         /// <summary>
+         /// Frequencies of the DFT bins actually tracked
+         /// </summary>
+         void GetFrequencies(WriteOnlyArray<double>^ frequencies);
+
+         /// <summary>
+         /// True once every channel has received at least windowLength samples
+         /// </summary>
+         property bool IsReady { bool get(); }
+
+      private:
+         double m_timeStep;
+      };
+   }
+}
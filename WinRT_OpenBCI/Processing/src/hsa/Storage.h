@@ -0,0 +1,207 @@
+/*
+*    Copyright 2017 Mikhail Vasilyev
+*
+*    Licensed under the Apache License, Version 2.0 (the "License");
+*    you may not use this file except in compliance with the License.
+*    You may obtain a copy of the License at
+*
+*        http://www.apache.org/licenses/LICENSE-2.0
+*
+*    Unless required by applicable law or agreed to in writing, software
+*    distributed under the License is distributed on an "AS IS" BASIS,
+*    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+*    See the License for the specific language governing permissions and
+*    limitations under the License.
+*/
+#pragma once
+#include <vector>
+#include <cstdint>
+#include <cstring>
+#include <cmath>
+#include <cassert>
+#include <algorithm>
+#include <type_traits>
+#include "HilbertOptions.h"
+
+namespace Processing
+{
+#pragma region Half precision
+
+   // IEEE 754 binary16, round to nearest even
+   inline uint16_t FloatToHalf(float value)
+   {
+      uint32_t bits;
+      std::memcpy(&bits, &value, sizeof(bits));
+      const uint16_t sign = (uint16_t)((bits >> 16) & 0x8000u);
+      const uint32_t absBits = bits & 0x7FFFFFFFu;
+
+      if (absBits >= 0x7F800000u) // inf or NaN
+         return sign | 0x7C00u | (absBits > 0x7F800000u ? 0x0200u : 0u);
+      if (absBits >= 0x477FF000u) // rounds to a value beyond 65504
+         return sign | 0x7C00u;
+      if (absBits < 0x38800000u) { // subnormal half or zero
+         if (absBits < 0x33000000u)
+            return sign;
+         const uint32_t mantissa = (absBits & 0x007FFFFFu) | 0x00800000u;
+         const int shift = 126 - (int)(absBits >> 23); // 14..24
+         uint32_t half = mantissa >> shift;
+         const uint32_t rest = mantissa & ((1u << shift) - 1);
+         const uint32_t halfway = 1u << (shift - 1);
+         if (rest > halfway || (rest == halfway && (half & 1u)))
+            half++;
+         return sign | (uint16_t)half;
+      }
+      uint32_t half = ((absBits - 0x38000000u) >> 13);
+      const uint32_t rest = absBits & 0x1FFFu;
+      if (rest > 0x1000u || (rest == 0x1000u && (half & 1u)))
+         half++; // may carry into the exponent, which is still correct
+      return sign | (uint16_t)half;
+   }
+
+   inline float HalfToFloat(uint16_t half)
+   {
+      const uint32_t sign = (uint32_t)(half & 0x8000u) << 16;
+      const uint32_t exponent = (half >> 10) & 0x1Fu;
+      uint32_t mantissa = half & 0x03FFu;
+      uint32_t bits;
+
+      if (exponent == 0x1Fu) {
+         bits = sign | 0x7F800000u | (mantissa << 13);
+      }
+      else if (exponent != 0) {
+         bits = sign | ((exponent + 112u) << 23) | (mantissa << 13);
+      }
+      else if (mantissa == 0) {
+         bits = sign;
+      }
+      else { // subnormal, normalize
+         int e = -1;
+         do {
+            mantissa <<= 1;
+            e++;
+         } while (!(mantissa & 0x0400u));
+         bits = sign | ((uint32_t)(112 - e) << 23) | ((mantissa & 0x03FFu) << 13);
+      }
+      float value;
+      std::memcpy(&value, &bits, sizeof(value));
+      return value;
+   }
+
+#pragma endregion
+
+
+   /// <summary>
+   /// Instantaneous amplitudes and frequencies of all IMFs in one contiguous structure-of-arrays block.
+   /// Frequencies can be kept in 16 bits, either as half floats or quantized linearly over each IMF's range.
+   /// </summary>
+   template <typename TData, typename = std::enable_if_t<std::is_floating_point_v<TData>>>
+   class ImfAttributeStore final
+   {
+      const int m_imfCount;
+      const int m_length; // samples per IMF, there is one frequency less
+      const FrequencyStorage m_storage;
+
+      std::vector<TData> m_ampl;       // [imf][length]
+      std::vector<TData> m_freq;       // [imf][length - 1], Full only
+      std::vector<uint16_t> m_packed;  // [imf][length - 1], Half and Quantized16
+      std::vector<TData> m_freqOffset; // [imf], Quantized16
+      std::vector<TData> m_freqStep;   // [imf], Quantized16
+
+   public:
+      ImfAttributeStore(int imfCount, int length, FrequencyStorage storage)
+         : m_imfCount(imfCount), m_length(length), m_storage(storage),
+         m_ampl((size_t)imfCount * length),
+         m_freq(storage == FrequencyStorage::Full ? (size_t)imfCount * (length - 1) : 0),
+         m_packed(storage == FrequencyStorage::Full ? 0 : (size_t)imfCount * (length - 1)),
+         m_freqOffset(imfCount, (TData)0.0), m_freqStep(imfCount, (TData)0.0)
+      {
+         assert(imfCount > 0 && length > 0);
+      }
+      int GetImfCount() const noexcept
+      {
+         return m_imfCount;
+      }
+      int GetLength() const noexcept
+      {
+         return m_length;
+      }
+      bool IsCompact() const noexcept
+      {
+         return m_storage != FrequencyStorage::Full;
+      }
+      // Bytes held by the attribute arrays
+      size_t GetByteSize() const noexcept
+      {
+         return m_ampl.size() * sizeof(TData) + m_freq.size() * sizeof(TData) + m_packed.size() * sizeof(uint16_t);
+      }
+      TData *GetAmplitudes(int imf) noexcept
+      {
+         return m_ampl.data() + (size_t)imf * m_length;
+      }
+      const TData *GetAmplitudes(int imf) const noexcept
+      {
+         return m_ampl.data() + (size_t)imf * m_length;
+      }
+      // Destination for the kernels when frequencies are stored in full precision, null otherwise
+      TData *GetFrequencyBuffer(int imf) noexcept
+      {
+         return IsCompact() ? nullptr : m_freq.data() + (size_t)imf * (m_length - 1);
+      }
+      // Packs the frequencies of one IMF, fmin and fmax must bound them. Different IMFs may be stored concurrently.
+      void StoreFrequencies(int imf, const TData *pfreq, TData fmin, TData fmax)
+      {
+         const int count = m_length - 1;
+         if (!IsCompact()) {
+            if (pfreq != GetFrequencyBuffer(imf))
+               std::copy(pfreq, pfreq + count, GetFrequencyBuffer(imf));
+            return;
+         }
+         uint16_t *pdest = m_packed.data() + (size_t)imf * count;
+         if (m_storage == FrequencyStorage::Half) {
+            for (int i = 0; i < count; ++i)
+               pdest[i] = FloatToHalf((float)pfreq[i]);
+         }
+         else {
+            const TData step = fmax > fmin ? (fmax - fmin) / (TData)65535.0 : (TData)1.0;
+            const TData invStep = (TData)1.0 / step;
+            for (int i = 0; i < count; ++i) {
+               TData q = std::round((pfreq[i] - fmin) * invStep);
+               pdest[i] = (uint16_t)std::min(std::max(q, (TData)0.0), (TData)65535.0);
+            }
+            m_freqOffset[imf] = fmin;
+            m_freqStep[imf] = step;
+         }
+      }
+      // Frequencies of one IMF. Compact storage is decoded into pscratch, which must then outlive the result.
+      const TData *GetFrequencies(int imf, std::vector<TData> *pscratch) const
+      {
+         const int count = m_length - 1;
+         if (!IsCompact())
+            return m_freq.data() + (size_t)imf * count;
+
+         pscratch->resize(count);
+         TData *pdest = pscratch->data();
+         for (int i = 0; i < count; ++i)
+            pdest[i] = GetFrequencyAt(imf, i);
+         return pdest;
+      }
+      TData GetAmplitudeAt(int imf, int t) const
+      {
+         assert(t < m_length);
+         return m_ampl[(size_t)imf * m_length + t];
+      }
+      TData GetFrequencyAt(int imf, int t) const
+      {
+         assert(t < m_length - 1);
+         const size_t index = (size_t)imf * (m_length - 1) + t;
+         switch (m_storage) {
+         case FrequencyStorage::Full:
+            return m_freq[index];
+         case FrequencyStorage::Half:
+            return (TData)HalfToFloat(m_packed[index]);
+         default:
+            return m_freqOffset[imf] + m_freqStep[imf] * m_packed[index];
+         }
+      }
+   };
+}
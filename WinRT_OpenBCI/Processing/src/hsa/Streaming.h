@@ -0,0 +1,151 @@
+/*
+*    Copyright 2017 Mikhail Vasilyev
+*
+*    Licensed under the Apache License, Version 2.0 (the "License");
+*    you may not use this file except in compliance with the License.
+*    You may obtain a copy of the License at
+*
+*        http://www.apache.org/licenses/LICENSE-2.0
+*
+*    Unless required by applicable law or agreed to in writing, software
+*    distributed under the License is distributed on an "AS IS" BASIS,
+*    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+*    See the License for the specific language governing permissions and
+*    limitations under the License.
+*/
+#pragma once
+#include <vector>
+#include <algorithm>
+#include <cmath>
+#include <cassert>
+#include <type_traits>
+#include "../simd/Simd.h"
+
+namespace Processing
+{
+   /// <summary>
+   /// Type III FIR approximation of the Hilbert transformer: h[k] = 2/(pi*k) for odd k,
+   /// Blackman-windowed. Output is delayed by (tapCount - 1) / 2 samples.
+   /// </summary>
+   template <typename TData, typename = std::enable_if_t<std::is_floating_point_v<TData>>>
+   class FirHilbertTransformer final
+   {
+      typedef Pack<TData> P;
+
+      const int m_tapCount;
+      std::vector<TData> m_coefs;  // reversed and zero-padded to a whole number of packs
+      std::vector<TData> m_buffer; // history stored twice, so the last m_tapCount samples are always contiguous
+      int m_pos;
+
+   public:
+      // tapCount is rounded up to the nearest odd number, at least 3
+      explicit FirHilbertTransformer(int tapCount)
+         : m_tapCount(std::max(3, tapCount | 1)), m_pos(0)
+      {
+         const int paddedLength = (m_tapCount + P::Width - 1) / P::Width * P::Width;
+         const int M = GetDelay();
+         const TData pi = (TData)3.14159265358979324;
+
+         m_coefs.assign(paddedLength, (TData)0.0);
+         m_buffer.assign(m_tapCount + paddedLength, (TData)0.0);
+
+         // m_coefs[j] multiplies x[n - (N-1) + j], i.e. h[M - j]
+         for (int j = 0; j < m_tapCount; ++j) {
+            int k = M - j;
+            if (k % 2 == 0)
+               continue;
+            TData window = (TData)0.42 - (TData)0.5 * std::cos(2 * pi * j / (m_tapCount - 1))
+                                       + (TData)0.08 * std::cos(4 * pi * j / (m_tapCount - 1));
+            m_coefs[j] = window * (TData)2.0 / (pi * k);
+         }
+      }
+      int GetTapCount() const noexcept
+      {
+         return m_tapCount;
+      }
+      int GetDelay() const noexcept
+      {
+         return (m_tapCount - 1) / 2;
+      }
+      // Adds x[n] and returns H{x}[n - GetDelay()]
+      TData Push(TData sample)
+      {
+         m_buffer[m_pos] = sample;
+         m_buffer[m_pos + m_tapCount] = sample;
+         m_pos = (m_pos + 1) % m_tapCount;
+
+         const TData *pwindow = &m_buffer[m_pos]; // oldest first, padding past the window meets zero coefficients
+         P acc((TData)0.0);
+         for (size_t j = 0; j < m_coefs.size(); j += P::Width)
+            acc = acc + P::Load(pwindow + j) * P::Load(&m_coefs[j]);
+         return acc.Sum();
+      }
+      // x[n - GetDelay()], the real part matching the last Push() result
+      TData GetDelayed() const
+      {
+         return m_buffer[m_pos + GetDelay()];
+      }
+   };
+
+   /// <summary>
+   /// Per-sample instantaneous amplitude, phase and frequency, same conventions as SpectralAnalyzerBase
+   /// (the analytic signal is conjugated so that frequency (phase[i-1] - phase[i]) / dt is positive).
+   /// </summary>
+   template <typename TData, typename = std::enable_if_t<std::is_floating_point_v<TData>>>
+   class StreamingAnalyticSignal final
+   {
+      FirHilbertTransformer<TData> m_fir;
+      const TData m_invTimestep;
+      long long m_count;
+
+      TData m_ampl, m_phase, m_freq;
+      TData m_wrappedPhase;
+
+   public:
+      StreamingAnalyticSignal(int tapCount, TData timestep)
+         : m_fir(tapCount), m_invTimestep((TData)1.0 / timestep), m_count(0),
+         m_ampl(0.0), m_phase(0.0), m_freq(0.0), m_wrappedPhase(0.0)
+      { }
+      // O(tapCount), attributes refer to the sample pushed GetDelay() samples ago
+      void Push(TData sample)
+      {
+         const TData pi = (TData)3.14159265358979324;
+
+         TData im = -m_fir.Push(sample);
+         TData re = m_fir.GetDelayed();
+         m_ampl = std::sqrt(re * re + im * im);
+
+         TData wrapped = std::atan2(im, re);
+         if (m_count == 0) {
+            m_phase = wrapped;
+         }
+         else {
+            TData dphase = std::remainder(wrapped - m_wrappedPhase, 2 * pi);
+            m_phase += dphase;
+            m_freq = -dphase * m_invTimestep;
+         }
+         m_wrappedPhase = wrapped;
+         m_count++;
+      }
+      bool IsReady() const noexcept
+      {
+         return m_count >= m_fir.GetTapCount();
+      }
+      int GetDelay() const noexcept
+      {
+         return m_fir.GetDelay();
+      }
+      TData GetAmplitude() const noexcept
+      {
+         return m_ampl;
+      }
+      TData GetPhase() const noexcept
+      {
+         return m_phase;
+      }
+      TData GetFrequency() const noexcept
+      {
+         return m_freq;
+      }
+   };
+}
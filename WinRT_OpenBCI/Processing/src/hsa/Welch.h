@@ -0,0 +1,101 @@
+/*
+*    Copyright 2017 Mikhail Vasilyev
+*
+*    Licensed under the Apache License, Version 2.0 (the "License");
+*    you may not use this file except in compliance with the License.
+*    You may obtain a copy of the License at
+*
+*        http://www.apache.org/licenses/LICENSE-2.0
+*
+*    Unless required by applicable law or agreed to in writing, software
+*    distributed under the License is distributed on an "AS IS" BASIS,
+*    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+*    See the License for the specific language governing permissions and
+*    limitations under the License.
+*/
+#pragma once
+#include <vector>
+#include <memory>
+#include <complex>
+#include <cmath>
+#include <cassert>
+#include <algorithm>
+#include <type_traits>
+#include "Analysis.h"
+
+namespace Processing
+{
+   /// <summary>
+   /// Welch power spectral density: Hann-windowed segments with 50% overlap, periodograms averaged.
+   /// A few FFTs per window instead of a full EEMD, used when the Hilbert path cannot keep up.
+   /// </summary>
+   template <typename TData, typename = std::enable_if_t<std::is_floating_point_v<TData>>>
+   class WelchEstimator final
+   {
+      typedef std::complex<TData> Cval;
+
+      int m_segmentLength; // power of 2
+      std::vector<TData> m_window;
+      TData m_windowPower; // sum of squared window values
+
+   public:
+      // segmentLength is rounded up to a power of 2
+      explicit WelchEstimator(int segmentLength)
+      {
+         m_segmentLength = 2;
+         while (m_segmentLength < segmentLength)
+            m_segmentLength *= 2;
+
+         const TData pi = (TData)3.14159265358979324;
+         m_window.resize(m_segmentLength);
+         m_windowPower = 0;
+         for (int i = 0; i < m_segmentLength; ++i) {
+            m_window[i] = (TData)0.5 - (TData)0.5 * std::cos(2 * pi * i / m_segmentLength); // periodic Hann
+            m_windowPower += m_window[i] * m_window[i];
+         }
+      }
+      int GetSegmentLength() const noexcept
+      {
+         return m_segmentLength;
+      }
+      // Number of one-sided bins, bin k is at 2*pi*k / (GetSegmentLength() * timestep) radians per time unit
+      int GetBinCount() const noexcept
+      {
+         return m_segmentLength / 2 + 1;
+      }
+      // One-sided PSD of length samples into ppsd (GetBinCount() values), so that summing
+      // ppsd[k] / (GetSegmentLength() * timestep) over all bins gives the signal variance.
+      // Signals shorter than one segment are zero-padded.
+      void Compute(const TData *psamples, int length, TData timestep, TData *ppsd) const
+      {
+         assert(length > 0);
+         const int L = m_segmentLength;
+         const int hop = L / 2;
+         std::fill(ppsd, ppsd + GetBinCount(), (TData)0.0);
+
+         TData mean = 0;
+         for (int i = 0; i < length; ++i)
+            mean += psamples[i];
+         mean /= length;
+
+         int segments = 0;
+         for (int start = 0; start == 0 || start + L <= length; start += hop) {
+            std::unique_ptr<TData[]> seg = std::make_unique<TData[]>(L);
+            for (int i = 0; i < L; ++i)
+               seg[i] = start + i < length ? (psamples[start + i] - mean) * m_window[i] : (TData)0.0;
+
+            int fftLength;
+            std::unique_ptr<Cval[]> spectrum = FastFourierTransform<TData>::Forward(std::move(seg), L, &fftLength);
+            assert(fftLength == L);
+            for (int k = 0; k < GetBinCount(); ++k)
+               ppsd[k] += std::norm(spectrum[k]);
+            segments++;
+         }
+
+         // density per Hz, positive frequencies carry the power of their negative twins
+         const TData scale = timestep / (m_windowPower * segments);
+         for (int k = 0; k < GetBinCount(); ++k)
+            ppsd[k] *= (k == 0 || k == L / 2) ? scale : 2 * scale;
+      }
+   };
+}
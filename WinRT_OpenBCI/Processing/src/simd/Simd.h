@@ -0,0 +1,325 @@
+/*
+*    Copyright 2017 Mikhail Vasilyev
+*
+*    Licensed under the Apache License, Version 2.0 (the "License");
+*    you may not use this file except in compliance with the License.
+*    You may obtain a copy of the License at
+*
+*        http://www.apache.org/licenses/LICENSE-2.0
+*
+*    Unless required by applicable law or agreed to in writing, software
+*    distributed under the License is distributed on an "AS IS" BASIS,
+*    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+*    See the License for the specific language governing permissions and
+*    limitations under the License.
+*/
+#pragma once
+#include <cmath>
+#include <complex>
+#include <algorithm>
+
+#if defined(_M_X64) || defined(_M_AMD64) || defined(__SSE2__)
+ #define PROCESSING_SSE2
+ #include <emmintrin.h>
+#endif
+
+namespace Processing
+{
+#pragma region Scalar pack
+
+   // Fallback wrapper used where no vector instruction set is available.
+   // Every specialization below exposes the same set of operations, so kernels
+   // can be written once as templates over Pack<TData>.
+   template <typename TData>
+   struct Pack
+   {
+      typedef bool Mask;
+      static constexpr int Width = 1;
+
+      TData v;
+
+      Pack() = default;
+      Pack(TData val) : v(val)
+      { }
+      static Pack Load(const TData *p)
+      {
+         return Pack(*p);
+      }
+      static void LoadComplex(const std::complex<TData> *p, Pack *pre, Pack *pim)
+      {
+         pre->v = p->real();
+         pim->v = p->imag();
+      }
+      void Store(TData *p) const
+      {
+         *p = v;
+      }
+      // [last lane of prev, lanes 0..Width-2 of cur]
+      static Pack ShiftIn(Pack prev, Pack cur)
+      {
+         return prev;
+      }
+      // inclusive prefix sum over lanes
+      Pack PrefixSum() const
+      {
+         return *this;
+      }
+      TData Last() const
+      {
+         return v;
+      }
+      TData Sum() const
+      {
+         return v;
+      }
+      TData MinLane() const
+      {
+         return v;
+      }
+      TData MaxLane() const
+      {
+         return v;
+      }
+   };
+
+   template <typename TData> inline Pack<TData> operator +(Pack<TData> a, Pack<TData> b) { return a.v + b.v; }
+   template <typename TData> inline Pack<TData> operator -(Pack<TData> a, Pack<TData> b) { return a.v - b.v; }
+   template <typename TData> inline Pack<TData> operator *(Pack<TData> a, Pack<TData> b) { return a.v * b.v; }
+   template <typename TData> inline Pack<TData> operator /(Pack<TData> a, Pack<TData> b) { return a.v / b.v; }
+   template <typename TData> inline Pack<TData> operator -(Pack<TData> a) { return -a.v; }
+   template <typename TData> inline bool operator <(Pack<TData> a, Pack<TData> b) { return a.v < b.v; }
+   template <typename TData> inline bool operator >(Pack<TData> a, Pack<TData> b) { return a.v > b.v; }
+   template <typename TData> inline Pack<TData> Min(Pack<TData> a, Pack<TData> b) { return a.v < b.v ? a.v : b.v; }
+   template <typename TData> inline Pack<TData> Max(Pack<TData> a, Pack<TData> b) { return a.v > b.v ? a.v : b.v; }
+   template <typename TData> inline Pack<TData> Abs(Pack<TData> a) { return std::abs(a.v); }
+   template <typename TData> inline Pack<TData> Sqrt(Pack<TData> a) { return std::sqrt(a.v); }
+   template <typename TData> inline Pack<TData> Round(Pack<TData> a) { return std::nearbyint(a.v); }
+   template <typename TData> inline Pack<TData> Select(bool mask, Pack<TData> a, Pack<TData> b) { return mask ? a : b; }
+   // 2^n for integral n within the normal exponent range
+   template <typename TData> inline Pack<TData> Pow2(Pack<TData> n) { return std::ldexp((TData)1.0, (int)n.v); }
+
+#pragma endregion
+
+
+#ifdef PROCESSING_SSE2
+#pragma region SSE2 packs
+
+   template <>
+   struct Pack<float>
+   {
+      struct Mask { __m128 m; };
+      static constexpr int Width = 4;
+
+      __m128 v;
+
+      Pack() = default;
+      Pack(__m128 val) : v(val)
+      { }
+      Pack(float val) : v(_mm_set1_ps(val))
+      { }
+      static Pack Load(const float *p)
+      {
+         return _mm_loadu_ps(p);
+      }
+      static void LoadComplex(const std::complex<float> *p, Pack *pre, Pack *pim)
+      {
+         __m128 a = _mm_loadu_ps(reinterpret_cast<const float *>(p));     // r0 i0 r1 i1
+         __m128 b = _mm_loadu_ps(reinterpret_cast<const float *>(p + 2)); // r2 i2 r3 i3
+         pre->v = _mm_shuffle_ps(a, b, _MM_SHUFFLE(2, 0, 2, 0));
+         pim->v = _mm_shuffle_ps(a, b, _MM_SHUFFLE(3, 1, 3, 1));
+      }
+      void Store(float *p) const
+      {
+         _mm_storeu_ps(p, v);
+      }
+      static Pack ShiftIn(Pack prev, Pack cur)
+      {
+         __m128 t = _mm_shuffle_ps(prev.v, cur.v, _MM_SHUFFLE(0, 0, 3, 3)); // p3 p3 c0 c0
+         return _mm_shuffle_ps(t, cur.v, _MM_SHUFFLE(2, 1, 2, 0));          // p3 c0 c1 c2
+      }
+      Pack PrefixSum() const
+      {
+         __m128 x = _mm_add_ps(v, _mm_castsi128_ps(_mm_slli_si128(_mm_castps_si128(v), 4)));
+         return _mm_add_ps(x, _mm_castsi128_ps(_mm_slli_si128(_mm_castps_si128(x), 8)));
+      }
+      float Last() const
+      {
+         return _mm_cvtss_f32(_mm_shuffle_ps(v, v, _MM_SHUFFLE(3, 3, 3, 3)));
+      }
+      float Sum() const
+      {
+         __m128 x = _mm_add_ps(v, _mm_movehl_ps(v, v));
+         return _mm_cvtss_f32(_mm_add_ss(x, _mm_shuffle_ps(x, x, _MM_SHUFFLE(1, 1, 1, 1))));
+      }
+      float MinLane() const
+      {
+         __m128 x = _mm_min_ps(v, _mm_movehl_ps(v, v));
+         return _mm_cvtss_f32(_mm_min_ss(x, _mm_shuffle_ps(x, x, _MM_SHUFFLE(1, 1, 1, 1))));
+      }
+      float MaxLane() const
+      {
+         __m128 x = _mm_max_ps(v, _mm_movehl_ps(v, v));
+         return _mm_cvtss_f32(_mm_max_ss(x, _mm_shuffle_ps(x, x, _MM_SHUFFLE(1, 1, 1, 1))));
+      }
+   };
+
+   inline Pack<float> operator +(Pack<float> a, Pack<float> b) { return _mm_add_ps(a.v, b.v); }
+   inline Pack<float> operator -(Pack<float> a, Pack<float> b) { return _mm_sub_ps(a.v, b.v); }
+   inline Pack<float> operator *(Pack<float> a, Pack<float> b) { return _mm_mul_ps(a.v, b.v); }
+   inline Pack<float> operator /(Pack<float> a, Pack<float> b) { return _mm_div_ps(a.v, b.v); }
+   inline Pack<float> operator -(Pack<float> a) { return _mm_xor_ps(a.v, _mm_set1_ps(-0.0f)); }
+   inline Pack<float>::Mask operator <(Pack<float> a, Pack<float> b) { return { _mm_cmplt_ps(a.v, b.v) }; }
+   inline Pack<float>::Mask operator >(Pack<float> a, Pack<float> b) { return { _mm_cmpgt_ps(a.v, b.v) }; }
+   inline Pack<float> Min(Pack<float> a, Pack<float> b) { return _mm_min_ps(a.v, b.v); }
+   inline Pack<float> Max(Pack<float> a, Pack<float> b) { return _mm_max_ps(a.v, b.v); }
+   inline Pack<float> Abs(Pack<float> a) { return _mm_andnot_ps(_mm_set1_ps(-0.0f), a.v); }
+   inline Pack<float> Sqrt(Pack<float> a) { return _mm_sqrt_ps(a.v); }
+   inline Pack<float> Round(Pack<float> a) { return _mm_cvtepi32_ps(_mm_cvtps_epi32(a.v)); } // |a| < 2^31
+   inline Pack<float> Select(Pack<float>::Mask mask, Pack<float> a, Pack<float> b)
+   {
+      return _mm_or_ps(_mm_and_ps(mask.m, a.v), _mm_andnot_ps(mask.m, b.v));
+   }
+   inline Pack<float> Pow2(Pack<float> n)
+   {
+      __m128i e = _mm_add_epi32(_mm_cvtps_epi32(n.v), _mm_set1_epi32(127));
+      return _mm_castsi128_ps(_mm_slli_epi32(e, 23));
+   }
+
+   template <>
+   struct Pack<double>
+   {
+      struct Mask { __m128d m; };
+      static constexpr int Width = 2;
+
+      __m128d v;
+
+      Pack() = default;
+      Pack(__m128d val) : v(val)
+      { }
+      Pack(double val) : v(_mm_set1_pd(val))
+      { }
+      static Pack Load(const double *p)
+      {
+         return _mm_loadu_pd(p);
+      }
+      static void LoadComplex(const std::complex<double> *p, Pack *pre, Pack *pim)
+      {
+         __m128d a = _mm_loadu_pd(reinterpret_cast<const double *>(p));     // r0 i0
+         __m128d b = _mm_loadu_pd(reinterpret_cast<const double *>(p + 1)); // r1 i1
+         pre->v = _mm_unpacklo_pd(a, b);
+         pim->v = _mm_unpackhi_pd(a, b);
+      }
+      void Store(double *p) const
+      {
+         _mm_storeu_pd(p, v);
+      }
+      static Pack ShiftIn(Pack prev, Pack cur)
+      {
+         return _mm_shuffle_pd(prev.v, cur.v, 1); // p1 c0
+      }
+      Pack PrefixSum() const
+      {
+         return _mm_add_pd(v, _mm_castsi128_pd(_mm_slli_si128(_mm_castpd_si128(v), 8)));
+      }
+      double Last() const
+      {
+         return _mm_cvtsd_f64(_mm_unpackhi_pd(v, v));
+      }
+      double Sum() const
+      {
+         return _mm_cvtsd_f64(_mm_add_sd(v, _mm_unpackhi_pd(v, v)));
+      }
+      double MinLane() const
+      {
+         return _mm_cvtsd_f64(_mm_min_sd(v, _mm_unpackhi_pd(v, v)));
+      }
+      double MaxLane() const
+      {
+         return _mm_cvtsd_f64(_mm_max_sd(v, _mm_unpackhi_pd(v, v)));
+      }
+   };
+
+   inline Pack<double> operator +(Pack<double> a, Pack<double> b) { return _mm_add_pd(a.v, b.v); }
+   inline Pack<double> operator -(Pack<double> a, Pack<double> b) { return _mm_sub_pd(a.v, b.v); }
+   inline Pack<double> operator *(Pack<double> a, Pack<double> b) { return _mm_mul_pd(a.v, b.v); }
+   inline Pack<double> operator /(Pack<double> a, Pack<double> b) { return _mm_div_pd(a.v, b.v); }
+   inline Pack<double> operator -(Pack<double> a) { return _mm_xor_pd(a.v, _mm_set1_pd(-0.0)); }
+   inline Pack<double>::Mask operator <(Pack<double> a, Pack<double> b) { return { _mm_cmplt_pd(a.v, b.v) }; }
+   inline Pack<double>::Mask operator >(Pack<double> a, Pack<double> b) { return { _mm_cmpgt_pd(a.v, b.v) }; }
+   inline Pack<double> Min(Pack<double> a, Pack<double> b) { return _mm_min_pd(a.v, b.v); }
+   inline Pack<double> Max(Pack<double> a, Pack<double> b) { return _mm_max_pd(a.v, b.v); }
+   inline Pack<double> Abs(Pack<double> a) { return _mm_andnot_pd(_mm_set1_pd(-0.0), a.v); }
+   inline Pack<double> Sqrt(Pack<double> a) { return _mm_sqrt_pd(a.v); }
+   inline Pack<double> Round(Pack<double> a) { return _mm_cvtepi32_pd(_mm_cvtpd_epi32(a.v)); } // |a| < 2^31
+   inline Pack<double> Select(Pack<double>::Mask mask, Pack<double> a, Pack<double> b)
+   {
+      return _mm_or_pd(_mm_and_pd(mask.m, a.v), _mm_andnot_pd(mask.m, b.v));
+   }
+   inline Pack<double> Pow2(Pack<double> n)
+   {
+      __m128i e = _mm_add_epi32(_mm_cvtpd_epi32(n.v), _mm_set1_epi32(1023));
+      e = _mm_unpacklo_epi32(e, _mm_setzero_si128()); // biased exponents are positive
+      return _mm_castsi128_pd(_mm_slli_epi64(e, 52));
+   }
+
+#pragma endregion
+#endif // PROCESSING_SSE2
+
+
+#pragma region Vectorized math
+
+   // Polynomial arctangent, |error| < 1e-5 rad over the whole range
+   template <typename TData>
+   inline Pack<TData> Atan2(Pack<TData> y, Pack<TData> x)
+   {
+      typedef Pack<TData> TPack;
+      const TPack ax = Abs(x), ay = Abs(y);
+      const TPack mx = Max(ax, ay);
+      const TPack a = Min(ax, ay) / Max(mx, TPack((TData)1e-30));
+      const TPack s = a * a;
+
+      TPack r = TPack((TData)-0.01172120);
+      r = r * s + TPack((TData)0.05265332);
+      r = r * s + TPack((TData)-0.11643287);
+      r = r * s + TPack((TData)0.19354346);
+      r = r * s + TPack((TData)-0.33262347);
+      r = r * s + TPack((TData)0.99997726);
+      r = r * a;
+
+      r = Select(ay > ax, TPack((TData)1.57079632679489662) - r, r);
+      r = Select(x < TPack((TData)0), TPack((TData)3.14159265358979324) - r, r);
+      r = Select(y < TPack((TData)0), -r, r);
+      return r;
+   }
+
+   // exp(x) by range reduction to |r| <= ln2/2 and a Taylor polynomial, within a few ulp;
+   // arguments are clamped to the range where the result is finite and normal
+   template <typename TData>
+   inline Pack<TData> Exp(Pack<TData> x)
+   {
+      typedef Pack<TData> TPack;
+      constexpr bool single = sizeof(TData) == sizeof(float);
+      constexpr int degree = single ? 7 : 13;
+      const TData limit = single ? (TData)87.0 : (TData)708.0;
+
+      x = Min(Max(x, TPack(-limit)), TPack(limit));
+      const TPack n = Round(x * TPack((TData)1.44269504088896341));
+      const TPack r = (x - n * TPack((TData)0.693145751953125)) - n * TPack((TData)1.42860682030941723e-6);
+
+      TPack p((TData)1.0);
+      for (int k = degree; k > 0; --k)
+         p = TPack((TData)1.0) + r * p * TPack((TData)1.0 / k);
+      return p * Pow2(n);
+   }
+
+   // Maps an angle to [-pi, pi]
+   template <typename TData>
+   inline Pack<TData> WrapAngle(Pack<TData> a)
+   {
+      typedef Pack<TData> TPack;
+      const TData twoPi = (TData)6.28318530717958648;
+      return a - TPack(twoPi) * Round(a * TPack((TData)1.0 / twoPi));
+   }
+
+#pragma endregion
+}
@@ -15,6 +15,10 @@ namespace RTGui
     {
         private bool _ready;
         private readonly Classifier _classifier;
+        private readonly FeatureExtractor _extractor;
+        private readonly IHilbertSpectrum[] _spectra;
+        private readonly double[][] _channelData;
+        private int _channelsArrived; // bit per channel of the current window
         private object _inputDataLock = new object();
         private readonly List<double> _inputData;
         private volatile int _mode; // -1 = idle, -2 = classifying new data
@@ -25,6 +29,10 @@ namespace RTGui
         /// </summary>
         public event Action<int> SampleClassified;
 
+        private const int ImfFeatureCount = 4;
+        private const double ImfEnergyThreshold = 0.01;
+        private const int WelchSegmentLength = 128;
+
         /// <summary>
         /// Number of modes to classify = output layer size in a NN
         /// </summary>
@@ -37,6 +45,14 @@ namespace RTGui
             ModeCount = modeCount;
             _inputData = new List<double>();
             _classifier = new Classifier();
+            _spectra = new IHilbertSpectrum[8];
+            _channelData = new double[8][];
+
+            // fixed bands up to the Nyquist frequency (time step is 1 sample), so features keep their meaning between windows
+            var edges = new double[inputSize + 1];
+            for (int i = 0; i <= inputSize; ++i)
+                edges[i] = Math.PI * i / inputSize;
+            _extractor = new FeatureExtractor(edges, ImfFeatureCount, ImfEnergyThreshold);
             
             _mode = -1;
             _ready = false;
@@ -47,9 +63,9 @@ namespace RTGui
         {
             NetworkType = type;
             if (type == NeuralNetworkType.BackPropagating)
-                _classifier.CreateFixedSizeNetwork(InputSize * 8, InputSize * 4, ModeCount, 2); // 1 hidden layer + 1 output layer
+                _classifier.CreateFixedSizeNetwork(FeatureCount * 8, FeatureCount * 4, ModeCount, 2); // 1 hidden layer + 1 output layer
             else if (type == NeuralNetworkType.CascadeCorrelation)
-                _classifier.CreateCascadeNetwork(InputSize * 8, ModeCount);
+                _classifier.CreateCascadeNetwork(FeatureCount * 8, ModeCount);
             _ready = true;
         }
         public NeuralNetworkType NetworkType
@@ -59,11 +75,16 @@ namespace RTGui
             get => _examplesCollected / 3; // 2 for training, 1 for validation
         }
         /// <summary>
-        /// Input vector size per channel
+        /// Number of frequency bands per channel
         /// </summary>
         public int InputSize
         { get; }
         /// <summary>
+        /// Input vector size per channel: bands followed by per-IMF statistics
+        /// </summary>
+        public int FeatureCount
+        { get => _extractor.FeatureCount; }
+        /// <summary>
         /// Output vector size
         /// </summary>
         public int ModeCount
@@ -76,6 +97,7 @@ namespace RTGui
             lock (_inputDataLock) {
                 _inputData.Clear();
             }
+            _channelsArrived = 0; // channels seen before this call belong to a window that is dropped
             _mode = mode;
         }
         public void StartClassifying()
@@ -85,6 +107,7 @@ namespace RTGui
             lock (_inputDataLock) {
                 _inputData.Clear();
             }
+            _channelsArrived = 0; // channels seen before this call belong to a window that is dropped
             _mode = -2;
         }
         public void Stop()
@@ -114,19 +137,28 @@ namespace RTGui
                 lock (_inputDataLock) {
                     _inputData.Clear();
                 }
+                Array.Clear(_spectra, 0, _spectra.Length);
+                Array.Clear(_channelData, 0, _channelData.Length);
+                _channelsArrived = 0;
             }
 
-            if (hs != null) {
-                double interval = hs.MaxFrequency / InputSize;
+            _spectra[channel] = hs;
+            _channelData[channel] = channelData;
+            _channelsArrived |= 1 << channel;
+
+            // a window joined midway or missing a channel is dropped
+            if (channel == 7 && _channelsArrived == 0xFF) {
+                double[] features = new double[FeatureCount * 8];
+                if (DataManager.Current.Degraded)
+                    _extractor.ExtractSpectral(_channelData.SelectMany(data => data).ToArray(), 8, 1.0, WelchSegmentLength, features);
+                else
+                    _extractor.Extract(_spectra, features);
                 lock (_inputDataLock) {
-                    for (int i = 0; i < InputSize; ++i) {
-                        double w = i * interval;
-                        _inputData.Add(hs.ComputeMarginalAt(w));
-                    }
+                    _inputData.AddRange(features);
                 }
             }
 
-            if (channel == 7 && _inputData.Count == InputSize * 8) {
+            if (channel == 7 && _channelsArrived == 0xFF && _inputData.Count == FeatureCount * 8) {
                 double[] output = new double[ModeCount];
 
                 if (_mode == -2) {
@@ -23,6 +23,12 @@ namespace RTGui
 
         public const double ScaleFactor = 0.02235; //  uV per count
 
+        // Degraded mode ends after this many consecutive samples found the queue empty,
+        // EEMD then resumes with parameters well above the floor that could not keep up
+        private const int RecoveryPolls = 5;
+        private const int RecoverySampleSize = 500;
+        private const int RecoveryEnsembleCount = 50;
+
 
         public event Action<IHilbertSpectrum, double[], int> SampleAnalysed;
 
@@ -34,6 +40,8 @@ namespace RTGui
 
         private readonly ConcurrentQueue<List<BciData>> _queue;
         private volatile bool _queueStopped;
+        private volatile bool _degraded;
+        private int _idlePolls;
 
         private DataManager()
         {
@@ -74,11 +82,14 @@ namespace RTGui
                             for (int i = 0; i < sample.Count; ++i)
                                 yValues[i] = sample[i].ChannelData[channel] * ScaleFactor;
 
-                            IImfDecomposition decomp = await Emd.EnsembleDecomposeAsync(xValues, yValues, 1000, _ensembleCount);
-                            //var decomp = await Emd.DecomposeAsync(xValues, yValues);
+                            IHilbertSpectrum spectrum = null;
+                            if (!_degraded) {
+                                IImfDecomposition decomp = await Emd.EnsembleDecomposeAsync(xValues, yValues, 1000, _ensembleCount);
+                                //var decomp = await Emd.DecomposeAsync(xValues, yValues);
 
-                            IHilbertSpectrum spectrum = (decomp.ImfFunctions.Count == 0) ?
-                                                        null : await Hsa.GetHilbertSpectrumAsync(decomp, 1.0);
+                                if (decomp.ImfFunctions.Count > 0)
+                                    spectrum = await Hsa.GetHilbertSpectrumAsync(decomp, 1.0);
+                            }
 
                             SampleAnalysed?.Invoke(spectrum, yValues, channel);
                         }
@@ -128,6 +139,14 @@ namespace RTGui
         {
             get => _ensembleCount;
         }
+        /// <summary>
+        /// True while EEMD is skipped because the queue could not be drained even with the smallest parameters.
+        /// Subscribers then receive null spectra and should fall back to spectral estimates of the raw data.
+        /// </summary>
+        public bool Degraded
+        {
+            get => _degraded;
+        }
         private void AdjustParameters(int e, int de)
         {
             int u = 20 * e + 15 * de; // PD-controller
@@ -135,13 +154,30 @@ namespace RTGui
             Debug.WriteLine($"--- P-term = {10 * e}, D-term = {20 * de} ---");
             Debug.WriteLine($"PD-controller output = {u}\nEnsemble count = {_ensembleCount}\nSample size = {_sampleSize}");
 
+            if (_degraded) {
+                // back to EEMD once the backlog has stayed away for a while
+                _idlePolls = e == 0 ? _idlePolls + 1 : 0;
+                if (_idlePolls >= RecoveryPolls) {
+                    _idlePolls = 0;
+                    _sampleSize = RecoverySampleSize;
+                    _ensembleCount = RecoveryEnsembleCount;
+                    _degraded = false;
+                    Debug.WriteLine("Switching back to EEMD");
+                }
+                return;
+            }
+
             _ensembleCount -= u;
             if (_ensembleCount < 10) {
                 _ensembleCount = 10;
 
                 _sampleSize -= u;
-                if (_sampleSize < 100)
-                    Stop();
+                if (_sampleSize < 100) {
+                    _sampleSize = 100;
+                    _degraded = true;
+                    _idlePolls = 0;
+                    Debug.WriteLine("Switching to Welch spectra");
+                }
             }
         }
     }
@@ -74,9 +74,10 @@ namespace RTGui
                 List<double> spectrumData = new List<double>();
                 List<double> spectrumFreq = new List<double>();
 
+                double[] marginal = maxFreq > 0 ? spectrum.ComputeMarginal(1000, 0.0, maxFreq) : new double[1000];
                 for (int i = 0; i < 1000; ++i) {
                     double freq = step * i;
-                    double value = spectrum.ComputeMarginalAt(freq);
+                    double value = marginal[i];
                     spectrumData.Add(value);
                     spectrumFreq.Add(freq);
                     avgSpectrum += value;
@@ -82,10 +82,11 @@ namespace RTGui
 
             _xStep = hs.MaxFrequency / XLength;
 
-            var marginalData = new ChartValues<double>();
-            for (double w = 0; w <= hs.MaxFrequency; w += _xStep) {
-                marginalData.Add(hs.ComputeMarginalAt(w));
-            }
+            // XLength + 1 bins starting at 0, 1 * _xStep, ..., MaxFrequency; a flat spectrum has no bins to fill
+            double[] marginal = hs.MaxFrequency > 0
+                ? hs.ComputeMarginal(XLength + 1, 0.0, hs.MaxFrequency + _xStep)
+                : new double[XLength + 1];
+            var marginalData = new ChartValues<double>(marginal);
 
             double marginalMin = marginalData[0], marginalMax = marginalData[0], marginalMean = 0.0;
             foreach (double val in marginalData) {